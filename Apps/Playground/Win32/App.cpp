@@ -17,6 +17,7 @@
 #include <Babylon/Plugins/NativeXr.h>
 #include <Babylon/Polyfills/Console.h>
 #include <Babylon/Polyfills/Window.h>
+#include <Babylon/Polyfills/Worker.h>
 #include <Babylon/Polyfills/XMLHttpRequest.h>
 
 #define MAX_LOADSTRING 100
@@ -113,6 +114,16 @@ namespace
             Babylon::Polyfills::Window::Initialize(env);
             Babylon::Polyfills::XMLHttpRequest::Initialize(env);
 
+            // Workers get the same polyfills, though none of the plugins, which depend on the graphics device.
+            Babylon::Polyfills::Worker::Initialize(env, [](Napi::Env workerEnv) {
+                Babylon::Polyfills::Console::Initialize(workerEnv, [](const char* message, auto) {
+                    OutputDebugStringA(message);
+                });
+
+                Babylon::Polyfills::Window::Initialize(workerEnv);
+                Babylon::Polyfills::XMLHttpRequest::Initialize(workerEnv);
+            });
+
             // Initialize NativeEngine plugin.
             graphics->AddToJavaScript(env);
             Babylon::Plugins::NativeEngine::Initialize(env, RENDER_ON_JS_THREAD);
@@ -15,6 +15,7 @@
 #include <Babylon/Plugins/NativeEngine.h>
 #include <Babylon/Polyfills/Console.h>
 #include <Babylon/Polyfills/Window.h>
+#include <Babylon/Polyfills/Worker.h>
 #include <Babylon/Polyfills/XMLHttpRequest.h>
 
 static const char* s_applicationName  = "BabylonNative Playground";
@@ -69,6 +70,17 @@ namespace
             Babylon::Polyfills::Window::Initialize(env);
             Babylon::Polyfills::XMLHttpRequest::Initialize(env);
 
+            // Workers get the same polyfills, though none of the plugins, which depend on the graphics device.
+            Babylon::Polyfills::Worker::Initialize(env, [](Napi::Env workerEnv) {
+                Babylon::Polyfills::Console::Initialize(workerEnv, [](const char* message, auto) {
+                    printf("%s", message);
+                    fflush(stdout);
+                });
+
+                Babylon::Polyfills::Window::Initialize(workerEnv);
+                Babylon::Polyfills::XMLHttpRequest::Initialize(workerEnv);
+            });
+
             // Initialize NativeEngine plugin.
             graphics->AddToJavaScript(env);
             Babylon::Plugins::NativeEngine::Initialize(env);
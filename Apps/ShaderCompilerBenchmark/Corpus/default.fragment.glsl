@@ -0,0 +1,131 @@
+#define SHADER_NAME fragment:default
+precision highp float;
+
+#define DIFFUSE
+#define DIFFUSEDIRECTUV 1
+#define NORMAL
+#define SPECULARTERM
+#define LIGHT0
+#define HEMILIGHT0
+#define LIGHT1
+#define POINTLIGHT1
+#define FOG
+#define FOGMODE_EXP2 2.
+
+uniform vec4 vEyePosition;
+uniform vec4 vDiffuseColor;
+uniform vec4 vSpecularColor;
+uniform vec3 vEmissiveColor;
+uniform vec3 vAmbientColor;
+uniform vec2 vDiffuseInfos;
+uniform float visibility;
+
+uniform vec4 vLightData0;
+uniform vec4 vLightDiffuse0;
+uniform vec4 vLightSpecular0;
+uniform vec3 vLightGround0;
+
+uniform vec4 vLightData1;
+uniform vec4 vLightDiffuse1;
+uniform vec4 vLightSpecular1;
+uniform vec4 vLightFalloff1;
+
+uniform vec4 vFogInfos;
+uniform vec3 vFogColor;
+
+uniform sampler2D diffuseSampler;
+
+in vec3 vPositionW;
+in vec3 vNormalW;
+in vec2 vDiffuseUV;
+in vec4 vViewPos;
+
+out vec4 glFragColor;
+
+struct lightingInfo
+{
+    vec3 diffuse;
+    vec3 specular;
+};
+
+lightingInfo computeHemisphericLighting(vec3 viewDirectionW, vec3 vNormal, vec4 lightData, vec3 diffuseColor, vec3 specularColor, vec3 groundColor, float glossiness)
+{
+    lightingInfo result;
+    float ndl = dot(vNormal, lightData.xyz) * 0.5 + 0.5;
+    result.diffuse = mix(groundColor, diffuseColor, ndl);
+
+    vec3 angleW = normalize(viewDirectionW + lightData.xyz);
+    float specComp = max(0., dot(vNormal, angleW));
+    specComp = pow(specComp, max(1., glossiness));
+    result.specular = specComp * specularColor;
+    return result;
+}
+
+lightingInfo computeLighting(vec3 viewDirectionW, vec3 vNormal, vec4 lightData, vec3 diffuseColor, vec3 specularColor, float range, float glossiness)
+{
+    lightingInfo result;
+    vec3 direction = lightData.xyz - vPositionW;
+    float attenuation = max(0., 1.0 - length(direction) / range);
+    vec3 lightVectorW = normalize(direction);
+
+    float ndl = max(0., dot(vNormal, lightVectorW));
+    result.diffuse = ndl * diffuseColor * attenuation;
+
+    vec3 angleW = normalize(viewDirectionW + lightVectorW);
+    float specComp = max(0., dot(vNormal, angleW));
+    specComp = pow(specComp, max(1., glossiness));
+    result.specular = specComp * specularColor * attenuation;
+    return result;
+}
+
+float CalcFogFactor()
+{
+    float fogCoeff = 1.0;
+    float fogDensity = vFogInfos.w;
+    float fogDistance = length(vViewPos);
+    fogCoeff = 1.0 / pow(2.71828, fogDistance * fogDistance * fogDensity * fogDensity);
+    return clamp(fogCoeff, 0.0, 1.0);
+}
+
+void main(void)
+{
+    vec3 viewDirectionW = normalize(vEyePosition.xyz - vPositionW);
+    vec4 baseColor = vec4(1., 1., 1., 1.);
+    vec3 diffuseColor = vDiffuseColor.rgb;
+    float alpha = vDiffuseColor.a;
+
+    vec3 normalW = normalize(vNormalW);
+    normalW = gl_FrontFacing ? normalW : -normalW;
+
+    baseColor = texture(diffuseSampler, vDiffuseUV);
+    baseColor.rgb *= vDiffuseInfos.y;
+
+    vec3 baseAmbientColor = vec3(1., 1., 1.);
+    float glossiness = vSpecularColor.a;
+    vec3 specularColor = vSpecularColor.rgb;
+
+    vec3 diffuseBase = vec3(0., 0., 0.);
+    vec3 specularBase = vec3(0., 0., 0.);
+
+    lightingInfo info = computeHemisphericLighting(viewDirectionW, normalW, vLightData0, vLightDiffuse0.rgb, vLightSpecular0.rgb, vLightGround0, glossiness);
+    diffuseBase += info.diffuse;
+    specularBase += info.specular;
+
+    info = computeLighting(viewDirectionW, normalW, vLightData1, vLightDiffuse1.rgb, vLightSpecular1.rgb, vLightDiffuse1.a, glossiness);
+    diffuseBase += info.diffuse;
+    specularBase += info.specular;
+
+    alpha = clamp(alpha * baseColor.a, 0.0, 1.0);
+
+    vec3 finalDiffuse = clamp(diffuseBase * diffuseColor + vEmissiveColor + vAmbientColor, 0.0, 1.0) * baseColor.rgb;
+    vec3 finalSpecular = specularBase * specularColor;
+
+    vec4 color = vec4(finalDiffuse * baseAmbientColor + finalSpecular, alpha);
+    color.rgb = max(color.rgb, 0.);
+
+    float fog = CalcFogFactor();
+    color.rgb = fog * color.rgb + (1.0 - fog) * vFogColor;
+
+    color.a *= visibility;
+    glFragColor = color;
+}
@@ -0,0 +1,54 @@
+#define SHADER_NAME vertex:default
+precision highp float;
+
+#define DIFFUSE
+#define DIFFUSEDIRECTUV 1
+#define NORMAL
+#define UV1
+#define NUM_BONE_INFLUENCERS 4
+#define BonesPerMesh 64
+#define FOG
+
+in vec3 position;
+in vec3 normal;
+in vec2 uv;
+in vec4 matricesIndices;
+in vec4 matricesWeights;
+
+uniform mat4 world;
+uniform mat4 view;
+uniform mat4 viewProjection;
+uniform mat4 mBones[BonesPerMesh];
+uniform mat4 diffuseMatrix;
+uniform float pointSize;
+
+out vec3 vPositionW;
+out vec3 vNormalW;
+out vec2 vDiffuseUV;
+out vec4 vViewPos;
+
+void main(void)
+{
+    vec3 positionUpdated = position;
+    vec3 normalUpdated = normal;
+
+    mat4 influence = mBones[int(matricesIndices[0])] * matricesWeights[0];
+    influence += mBones[int(matricesIndices[1])] * matricesWeights[1];
+    influence += mBones[int(matricesIndices[2])] * matricesWeights[2];
+    influence += mBones[int(matricesIndices[3])] * matricesWeights[3];
+    mat4 finalWorld = world * influence;
+
+    vec4 worldPos = finalWorld * vec4(positionUpdated, 1.0);
+    gl_Position = viewProjection * worldPos;
+
+    vPositionW = vec3(worldPos);
+
+    mat3 normalWorld = mat3(finalWorld);
+    vNormalW = normalize(normalWorld * normalUpdated);
+
+    vec2 uvUpdated = uv;
+    vDiffuseUV = vec2(diffuseMatrix * vec4(uvUpdated, 1.0, 0.0));
+
+    vViewPos = view * worldPos;
+    gl_PointSize = pointSize;
+}
@@ -0,0 +1,99 @@
+#define SHADER_NAME fragment:imageProcessing
+precision highp float;
+
+#define TONEMAPPING_ACES
+#define CONTRAST
+#define VIGNETTE
+#define VIGNETTEBLENDMODEMULTIPLY
+#define COLORCURVES
+
+#define LinearEncodePowerApprox 2.2
+#define GammaEncodePowerApprox 0.45454545454545454545454545454545
+#define RGBLuminanceCoefficients vec3(0.2126, 0.7152, 0.0722)
+
+uniform sampler2D textureSampler;
+uniform float exposureLinear;
+uniform float contrast;
+uniform vec2 vInverseScreenSize;
+uniform vec4 vignetteSettings1;
+uniform vec4 vignetteSettings2;
+uniform vec4 vCameraColorCurveNegative;
+uniform vec4 vCameraColorCurveNeutral;
+uniform vec4 vCameraColorCurvePositive;
+
+in vec2 vUV;
+
+out vec4 glFragColor;
+
+const mat3 ACESInputMat = mat3(
+    vec3(0.59719, 0.07600, 0.02840),
+    vec3(0.35458, 0.90834, 0.13383),
+    vec3(0.04823, 0.01566, 0.83777));
+
+const mat3 ACESOutputMat = mat3(
+    vec3(1.60475, -0.10208, -0.00327),
+    vec3(-0.53108, 1.10813, -0.07276),
+    vec3(-0.07367, -0.00605, 1.07602));
+
+vec3 RRTAndODTFit(vec3 v)
+{
+    vec3 a = v * (v + 0.0245786) - 0.000090537;
+    vec3 b = v * (0.983729 * v + 0.4329510) + 0.238081;
+    return a / b;
+}
+
+vec3 ACESFitted(vec3 color)
+{
+    color = ACESInputMat * color;
+    color = RRTAndODTFit(color);
+    color = ACESOutputMat * color;
+    return clamp(color, 0.0, 1.0);
+}
+
+float getLuminance(vec3 color)
+{
+    return clamp(dot(color, RGBLuminanceCoefficients), 0., 1.);
+}
+
+vec4 applyImageProcessing(vec4 result)
+{
+    result.rgb *= exposureLinear;
+
+    vec2 viewportXY = gl_FragCoord.xy * vInverseScreenSize;
+    viewportXY = viewportXY * 2.0 - 1.0;
+    vec3 vignetteXY1 = vec3(viewportXY * vignetteSettings1.xy + vignetteSettings1.zw, 1.0);
+    float vignetteTerm = dot(vignetteXY1, vignetteXY1);
+    float vignette = pow(vignetteTerm, vignetteSettings2.w);
+    vec3 vignetteColorMultiplier = mix(vec3(1.0), vignetteSettings2.rgb, vignette);
+    result.rgb *= vignetteColorMultiplier;
+
+    result.rgb = ACESFitted(result.rgb);
+    result.rgb = pow(result.rgb, vec3(GammaEncodePowerApprox));
+    result.rgb = clamp(result.rgb, 0.0, 1.0);
+
+    vec3 resultHighContrast = result.rgb * result.rgb * (3.0 - 2.0 * result.rgb);
+    if (contrast < 1.0)
+    {
+        result.rgb = mix(vec3(0.5, 0.5, 0.5), result.rgb, contrast);
+    }
+    else
+    {
+        result.rgb = mix(result.rgb, resultHighContrast, contrast - 1.0);
+    }
+
+    float luma = getLuminance(result.rgb);
+    vec2 curveMix = clamp(vec2(luma * 3.0 - 1.5, luma * -3.0 + 1.5), vec2(0.0), vec2(1.0));
+    vec4 colorCurve = vCameraColorCurveNeutral + curveMix.x * vCameraColorCurvePositive - curveMix.y * vCameraColorCurveNegative;
+    result.rgb *= colorCurve.rgb;
+    result.rgb = mix(vec3(luma), result.rgb, colorCurve.a);
+
+    return result;
+}
+
+void main(void)
+{
+    vec4 result = texture(textureSampler, vUV);
+    result.rgb = pow(result.rgb, vec3(LinearEncodePowerApprox));
+    result = applyImageProcessing(result);
+    glFragColor = result;
+}
@@ -0,0 +1,30 @@
+#define SHADER_NAME fragment:kernelBlur
+precision highp float;
+
+uniform sampler2D textureSampler;
+uniform vec2 delta;
+
+in vec2 vUV;
+
+out vec4 glFragColor;
+
+void main(void)
+{
+    vec2 sampleCoordS2 = vUV + (delta * -5.0769230769);
+    vec2 sampleCoordS1 = vUV + (delta * -3.2307692308);
+    vec2 sampleCoordS0 = vUV + (delta * -1.3846153846);
+    vec2 sampleCoordP0 = vUV + (delta * 1.3846153846);
+    vec2 sampleCoordP1 = vUV + (delta * 3.2307692308);
+    vec2 sampleCoordP2 = vUV + (delta * 5.0769230769);
+
+    vec4 blend = vec4(0.0);
+    blend += texture(textureSampler, sampleCoordS2) * 0.0702702703;
+    blend += texture(textureSampler, sampleCoordS1) * 0.3162162162;
+    blend += texture(textureSampler, sampleCoordS0) * 0.2270270270;
+    blend += texture(textureSampler, vUV) * 0.0540540541;
+    blend += texture(textureSampler, sampleCoordP0) * 0.2270270270;
+    blend += texture(textureSampler, sampleCoordP1) * 0.3162162162;
+    blend += texture(textureSampler, sampleCoordP2) * 0.0702702703;
+
+    glFragColor = blend;
+}
@@ -0,0 +1,23 @@
+#define SHADER_NAME fragment:layer
+precision highp float;
+
+#define ALPHATEST
+
+uniform sampler2D textureSampler;
+uniform vec4 color;
+
+in vec2 vUV;
+
+out vec4 glFragColor;
+
+void main(void)
+{
+    vec4 baseColor = texture(textureSampler, vUV);
+
+    if (baseColor.a < 0.4)
+    {
+        discard;
+    }
+
+    glFragColor = baseColor * color;
+}
@@ -0,0 +1,24 @@
+#define SHADER_NAME fragment:particles
+precision highp float;
+
+#define BLENDMULTIPLYMODE
+
+uniform vec4 textureMask;
+uniform sampler2D diffuseSampler;
+
+in vec2 vUV;
+in vec4 vColor;
+in vec3 vPositionW;
+
+out vec4 glFragColor;
+
+void main(void)
+{
+    vec4 textureColor = texture(diffuseSampler, vUV);
+    vec4 baseColor = (textureColor * textureMask + (vec4(1., 1., 1., 1.) - textureMask)) * vColor;
+
+    float sourceAlpha = vColor.a * textureColor.a;
+    baseColor.rgb = baseColor.rgb * sourceAlpha + vec3(1.0) * (1.0 - sourceAlpha);
+
+    glFragColor = baseColor;
+}
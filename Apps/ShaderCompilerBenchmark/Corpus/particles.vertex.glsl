@@ -0,0 +1,58 @@
+#define SHADER_NAME vertex:particles
+precision highp float;
+
+#define BILLBOARD
+#define ANIMATESHEET
+
+in vec3 position;
+in vec4 color;
+in float angle;
+in vec2 size;
+in float cellIndex;
+in vec2 offset;
+in vec2 uv;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 particlesInfos;
+uniform vec3 eyePosition;
+
+out vec2 vUV;
+out vec4 vColor;
+out vec3 vPositionW;
+
+vec3 rotate(vec3 yaxis, vec3 rotatedCorner)
+{
+    vec3 xaxis = normalize(cross(vec3(0., 1.0, 0.), yaxis));
+    vec3 zaxis = normalize(cross(yaxis, xaxis));
+
+    vec3 row0 = vec3(xaxis.x, xaxis.y, xaxis.z);
+    vec3 row1 = vec3(yaxis.x, yaxis.y, yaxis.z);
+    vec3 row2 = vec3(zaxis.x, zaxis.y, zaxis.z);
+
+    mat3 rotMatrix = mat3(row0, row1, row2);
+    vec3 alignedCorner = rotMatrix * rotatedCorner;
+    return position + alignedCorner;
+}
+
+void main(void)
+{
+    vec2 cornerPos = (vec2(offset.x - 0.5, offset.y - 0.5) - vec2(0.5, 0.5)) * size;
+
+    vec3 rotatedCorner;
+    rotatedCorner.x = cornerPos.x * cos(angle) - cornerPos.y * sin(angle);
+    rotatedCorner.y = cornerPos.x * sin(angle) + cornerPos.y * cos(angle);
+    rotatedCorner.z = 0.;
+
+    vec3 viewPos = (view * vec4(position, 1.0)).xyz + rotatedCorner;
+    vPositionW = position;
+    gl_Position = projection * vec4(viewPos, 1.0);
+
+    vColor = color;
+
+    float rowOffset = floor(cellIndex / particlesInfos.z);
+    float columnOffset = cellIndex - rowOffset * particlesInfos.z;
+    vec2 uvScale = particlesInfos.xy;
+    vec2 uvOffset = vec2(uv.x, 1.0 - uv.y);
+    vUV = (uvOffset + vec2(columnOffset, rowOffset)) * uvScale;
+}
@@ -0,0 +1,182 @@
+#define SHADER_NAME fragment:pbr
+precision highp float;
+
+#define ALBEDO
+#define BUMP
+#define METALLICWORKFLOW
+#define REFLECTION
+#define REFLECTIONMAP_CUBIC
+#define LODBASEDMICROSFURACE
+#define LIGHT0
+#define DIRLIGHT0
+#define IMAGEPROCESSINGPOSTPROCESS
+
+#define RECIPROCAL_PI 0.3183098861837907
+#define PI 3.1415926535897932384626433832795
+#define MINIMUMVARIANCE 0.0005
+
+uniform vec4 vEyePosition;
+uniform vec4 vAlbedoColor;
+uniform vec4 vReflectivityColor;
+uniform vec3 vEmissiveColor;
+uniform vec3 vAmbientColor;
+uniform vec2 vAlbedoInfos;
+uniform vec3 vBumpInfos;
+uniform vec2 vTangentSpaceParams;
+uniform vec2 vReflectionInfos;
+uniform vec3 vReflectionMicrosurfaceInfos;
+uniform mat4 reflectionMatrix;
+uniform vec3 vReflectionColor;
+uniform float visibility;
+uniform float exposureLinear;
+
+uniform vec4 vLightData0;
+uniform vec4 vLightDiffuse0;
+uniform vec4 vLightSpecular0;
+
+uniform sampler2D albedoSampler;
+uniform sampler2D bumpSampler;
+uniform samplerCube reflectionSampler;
+uniform sampler2D environmentBrdfSampler;
+
+in vec3 vPositionW;
+in vec3 vNormalW;
+in vec2 vAlbedoUV;
+in vec2 vBumpUV;
+in vec3 vPositionUVW;
+
+out vec4 glFragColor;
+
+float square(float value)
+{
+    return value * value;
+}
+
+vec3 toLinearSpace(vec3 color)
+{
+    return pow(color, vec3(2.2));
+}
+
+vec3 toGammaSpace(vec3 color)
+{
+    return pow(color, vec3(1.0 / 2.2));
+}
+
+mat3 cotangent_frame(vec3 normal, vec3 p, vec2 uv, vec2 tangentSpaceParams)
+{
+    vec3 dp1 = dFdx(p);
+    vec3 dp2 = dFdy(p);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    vec3 dp2perp = cross(dp2, normal);
+    vec3 dp1perp = cross(normal, dp1);
+    vec3 tangent = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 bitangent = dp2perp * duv1.y + dp1perp * duv2.y;
+
+    tangent *= tangentSpaceParams.x;
+    bitangent *= tangentSpaceParams.y;
+
+    float invmax = inversesqrt(max(dot(tangent, tangent), dot(bitangent, bitangent)));
+    return mat3(tangent * invmax, bitangent * invmax, normal);
+}
+
+vec3 perturbNormal(mat3 cotangentFrame, vec2 uv)
+{
+    vec3 map = texture(bumpSampler, uv).xyz;
+    map = map * 2.0 - 1.0;
+    map = normalize(map * vec3(vBumpInfos.y, vBumpInfos.y, 1.0));
+    return normalize(cotangentFrame * map);
+}
+
+float convertRoughnessToAverageSlope(float roughness)
+{
+    return square(roughness) + MINIMUMVARIANCE;
+}
+
+float normalDistributionFunction_TrowbridgeReitzGGX(float NdotH, float alphaG)
+{
+    float a2 = square(alphaG);
+    float d = NdotH * NdotH * (a2 - 1.0) + 1.0;
+    return a2 / (PI * d * d);
+}
+
+float smithVisibility_GGXCorrelated(float NdotL, float NdotV, float alphaG)
+{
+    float a2 = alphaG * alphaG;
+    float GGXV = NdotL * sqrt(NdotV * (NdotV - a2 * NdotV) + a2);
+    float GGXL = NdotV * sqrt(NdotL * (NdotL - a2 * NdotL) + a2);
+    return 0.5 / (GGXV + GGXL);
+}
+
+vec3 fresnelSchlickGGX(float VdotH, vec3 reflectance0, vec3 reflectance90)
+{
+    return reflectance0 + (reflectance90 - reflectance0) * pow(1.0 - VdotH, 5.0);
+}
+
+vec3 computeDirectionalLight(vec3 normalW, vec3 viewDirectionW, float NdotV, float alphaG, vec3 specularEnvironmentR0, vec3 specularEnvironmentR90, vec3 surfaceAlbedo, out vec3 specular)
+{
+    vec3 L = normalize(-vLightData0.xyz);
+    vec3 H = normalize(viewDirectionW + L);
+    float NdotL = max(dot(normalW, L), 0.0);
+    float NdotH = clamp(dot(normalW, H), 0.0, 1.0);
+    float VdotH = clamp(dot(viewDirectionW, H), 0.0, 1.0);
+
+    vec3 fresnel = fresnelSchlickGGX(VdotH, specularEnvironmentR0, specularEnvironmentR90);
+    float distribution = normalDistributionFunction_TrowbridgeReitzGGX(NdotH, alphaG);
+    float smithVisibility = smithVisibility_GGXCorrelated(NdotL, NdotV, alphaG);
+
+    specular = fresnel * distribution * smithVisibility * NdotL * vLightSpecular0.rgb;
+    return NdotL * vLightDiffuse0.rgb * surfaceAlbedo * RECIPROCAL_PI;
+}
+
+void main(void)
+{
+    vec3 viewDirectionW = normalize(vEyePosition.xyz - vPositionW);
+    vec3 normalW = normalize(vNormalW);
+
+    mat3 TBN = cotangent_frame(normalW * vBumpInfos.z, vPositionW, vBumpUV, vTangentSpaceParams);
+    normalW = perturbNormal(TBN, vBumpUV);
+    normalW = gl_FrontFacing ? normalW : -normalW;
+
+    vec3 surfaceAlbedo = vAlbedoColor.rgb;
+    float alpha = vAlbedoColor.a;
+    vec4 albedoTexture = texture(albedoSampler, vAlbedoUV);
+    surfaceAlbedo *= toLinearSpace(albedoTexture.rgb) * vAlbedoInfos.y;
+    alpha *= albedoTexture.a;
+
+    float metallic = vReflectivityColor.r;
+    float roughness = vReflectivityColor.g;
+    float microSurface = 1.0 - roughness;
+
+    vec3 baseColor = surfaceAlbedo;
+    vec3 metallicF0 = vec3(0.04);
+    surfaceAlbedo = mix(baseColor.rgb * (1.0 - metallicF0.r), vec3(0., 0., 0.), metallic);
+    vec3 specularEnvironmentR0 = mix(metallicF0, baseColor, metallic);
+    vec3 specularEnvironmentR90 = vec3(clamp(dot(specularEnvironmentR0, vec3(50.0)), 0.0, 1.0));
+
+    float alphaG = convertRoughnessToAverageSlope(roughness);
+    float NdotV = abs(dot(normalW, viewDirectionW)) + 0.00001;
+
+    vec3 reflectionVector = vec3(reflectionMatrix * vec4(reflect(-viewDirectionW, normalW), 0.));
+    float reflectionLOD = (1.0 - microSurface) * vReflectionMicrosurfaceInfos.x * vReflectionMicrosurfaceInfos.y + vReflectionMicrosurfaceInfos.z;
+    vec3 environmentRadiance = textureLod(reflectionSampler, reflectionVector, reflectionLOD).rgb * vReflectionInfos.x;
+    vec3 environmentIrradiance = textureLod(reflectionSampler, normalW, vReflectionMicrosurfaceInfos.x).rgb * vReflectionInfos.x;
+
+    vec2 brdfSamplerUV = vec2(NdotV, roughness);
+    vec3 environmentBrdf = texture(environmentBrdfSampler, brdfSamplerUV).rgb;
+    vec3 specularEnvironmentReflectance = specularEnvironmentR0 * environmentBrdf.x + specularEnvironmentR90 * environmentBrdf.y;
+
+    vec3 specularBase;
+    vec3 diffuseBase = computeDirectionalLight(normalW, viewDirectionW, NdotV, alphaG, specularEnvironmentR0, specularEnvironmentR90, surfaceAlbedo, specularBase);
+
+    vec3 finalIrradiance = environmentIrradiance * surfaceAlbedo * vReflectionColor;
+    vec3 finalRadiance = environmentRadiance * specularEnvironmentReflectance * vReflectionColor;
+
+    vec4 finalColor = vec4(diffuseBase + specularBase + finalIrradiance + finalRadiance + vAmbientColor * surfaceAlbedo + vEmissiveColor, alpha);
+    finalColor.rgb *= exposureLinear;
+    finalColor.rgb = toGammaSpace(max(finalColor.rgb, 0.0));
+    finalColor.a *= visibility;
+
+    glFragColor = finalColor;
+}
@@ -0,0 +1,55 @@
+#define SHADER_NAME vertex:pbr
+precision highp float;
+
+#define ALBEDO
+#define ALBEDODIRECTUV 1
+#define BUMP
+#define BUMPDIRECTUV 1
+#define METALLICWORKFLOW
+#define REFLECTION
+#define REFLECTIONMAP_CUBIC
+#define NORMAL
+#define UV1
+#define INSTANCES
+
+in vec3 position;
+in vec3 normal;
+in vec2 uv;
+in vec4 world0;
+in vec4 world1;
+in vec4 world2;
+in vec4 world3;
+
+uniform mat4 view;
+uniform mat4 viewProjection;
+uniform mat4 albedoMatrix;
+uniform mat4 bumpMatrix;
+uniform vec2 vAlbedoInfos;
+uniform vec3 vBumpInfos;
+
+out vec3 vPositionW;
+out vec3 vNormalW;
+out vec2 vAlbedoUV;
+out vec2 vBumpUV;
+out vec3 vPositionUVW;
+
+void main(void)
+{
+    vec3 positionUpdated = position;
+    vec3 normalUpdated = normal;
+    vec2 uvUpdated = uv;
+
+    vPositionUVW = positionUpdated;
+
+    mat4 finalWorld = mat4(world0, world1, world2, world3);
+    vec4 worldPos = finalWorld * vec4(positionUpdated, 1.0);
+    vPositionW = vec3(worldPos);
+
+    mat3 normalWorld = mat3(finalWorld);
+    vNormalW = normalize(normalWorld * normalUpdated);
+
+    gl_Position = viewProjection * worldPos;
+
+    vAlbedoUV = vec2(albedoMatrix * vec4(uvUpdated, 1.0, 0.0));
+    vBumpUV = vec2(bumpMatrix * vec4(uvUpdated, 1.0, 0.0));
+}
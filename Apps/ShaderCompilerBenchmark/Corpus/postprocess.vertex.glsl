@@ -0,0 +1,16 @@
+#define SHADER_NAME vertex:postprocess
+precision highp float;
+
+in vec2 position;
+
+uniform vec2 scale;
+
+out vec2 vUV;
+
+const vec2 madd = vec2(0.5, 0.5);
+
+void main(void)
+{
+    vUV = (position * madd + madd) * scale;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,27 @@
+#define SHADER_NAME fragment:shadowMap
+precision highp float;
+
+#define ESM
+
+uniform vec3 biasAndScale;
+
+in float vDepthMetric;
+
+out vec4 glFragColor;
+
+vec4 pack(float depth)
+{
+    const vec4 bit_shift = vec4(255.0 * 255.0 * 255.0, 255.0 * 255.0, 255.0, 1.0);
+    const vec4 bit_mask = vec4(0.0, 1.0 / 255.0, 1.0 / 255.0, 1.0 / 255.0);
+
+    vec4 res = fract(depth * bit_shift);
+    res -= res.xxyz * bit_mask;
+    return res;
+}
+
+void main(void)
+{
+    float depth = vDepthMetric;
+    depth = clamp(exp(-min(87., biasAndScale.z * depth)), 0., 1.);
+    glFragColor = pack(depth);
+}
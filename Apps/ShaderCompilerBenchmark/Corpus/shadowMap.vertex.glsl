@@ -0,0 +1,31 @@
+#define SHADER_NAME vertex:shadowMap
+precision highp float;
+
+#define NUM_BONE_INFLUENCERS 4
+#define BonesPerMesh 64
+
+in vec3 position;
+in vec4 matricesIndices;
+in vec4 matricesWeights;
+
+uniform mat4 world;
+uniform mat4 mBones[BonesPerMesh];
+uniform mat4 viewProjection;
+uniform vec3 biasAndScale;
+uniform vec2 depthValues;
+
+out float vDepthMetric;
+
+void main(void)
+{
+    mat4 influence = mBones[int(matricesIndices[0])] * matricesWeights[0];
+    influence += mBones[int(matricesIndices[1])] * matricesWeights[1];
+    influence += mBones[int(matricesIndices[2])] * matricesWeights[2];
+    influence += mBones[int(matricesIndices[3])] * matricesWeights[3];
+    mat4 finalWorld = world * influence;
+
+    vec4 worldPos = finalWorld * vec4(position, 1.0);
+    gl_Position = viewProjection * worldPos;
+
+    vDepthMetric = ((gl_Position.z + depthValues.x) / depthValues.y) + biasAndScale.x;
+}
@@ -0,0 +1,516 @@
+// Measures the performance of the shader compiler NativeEngine uses on the platform this tool is built for,
+// by repeatedly compiling the programs listed in a manifest, first on a single thread and then on several
+// threads sharing one compiler as NativeEngine does. The compilation throughput, the median and 99th
+// percentile latencies of a compilation, the time spent in each step of the compilation, and the peak memory
+// usage of the process are reported.
+//
+// The manifest lists the vertex and fragment sources of each program, see Babylon::ShaderManifest. Corpus/
+// holds one covering the standard, PBR, particle, post-process, and GUI materials of Babylon.js. More can be
+// written by Babylon::Plugins::NativeEngine::DumpShaderSources, for instance when running the ValidationTests
+// app with --dump-shaders <directory>.
+//
+// With --write-baseline <file>, the results are written to a file which a later run can be compared against
+// with --baseline <file>, failing if any result is worse than the baseline by more than the percentage given
+// by --tolerance (10% by default).
+//
+// With --compare-traversals, the time taken to modify each program with the single traversal of
+// ShaderCompilerTraversers::ModifyProgram is also compared against calling the individual modification
+// functions one after the other, each of which traverses the program again.
+//
+// No graphics device is needed, so this runs headless, for instance on CI. Exits with a non-zero code if any
+// program fails to compile, if the manifest lists no programs, or if the results regressed from the baseline.
+
+#include <ShaderCompiler.h>
+#include <ShaderCompilerTraversers.h>
+#include <ShaderManifest.h>
+#include <ResourceLimits.h>
+
+#include <glslang/Public/ShaderLang.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    using Babylon::ShaderManifest::Program;
+
+    struct Run
+    {
+        std::chrono::duration<double> Elapsed{};
+        std::vector<double> LatenciesMilliseconds{};
+        // The total of each step of the compilations, only when running on a single thread.
+        std::array<std::chrono::nanoseconds, Babylon::ShaderCompiler::Statistics::StageCount> StageDurations{};
+        std::array<size_t, Babylon::ShaderCompiler::Statistics::StageCount> StageRuns{};
+    };
+
+    std::vector<Program> LoadPrograms(const std::string& manifestPath)
+    {
+        std::vector<Program> programs{Babylon::ShaderManifest::Load(manifestPath)};
+        if (programs.empty())
+        {
+            throw std::runtime_error{manifestPath + ": no programs to compile."};
+        }
+
+        return programs;
+    }
+
+    // Compiles each program the given number of times, spreading the compilations over the given number of
+    // threads. Statistics are only gathered when running on a single thread.
+    Run Compile(Babylon::ShaderCompiler& compiler, const std::vector<Program>& programs, size_t iterations, size_t threadCount)
+    {
+        const size_t compilations{programs.size() * iterations};
+        std::atomic<size_t> nextCompilation{0};
+        std::vector<std::vector<double>> latencies(threadCount);
+        std::vector<std::exception_ptr> errors(threadCount);
+        Run run{};
+
+        const auto work = [&](size_t threadIndex) {
+            try
+            {
+                for (size_t compilation = nextCompilation++; compilation < compilations; compilation = nextCompilation++)
+                {
+                    const Program& program{programs[compilation % programs.size()]};
+                    Babylon::ShaderCompiler::Statistics statistics{};
+
+                    const auto start{std::chrono::steady_clock::now()};
+                    compiler.Compile(program.VertexSource, program.FragmentSource, statistics);
+                    latencies[threadIndex].push_back(std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count());
+
+                    if (threadCount == 1)
+                    {
+                        for (size_t index = 0; index < Babylon::ShaderCompiler::Statistics::StageCount; ++index)
+                        {
+                            run.StageDurations[index] += statistics.StageDurations[index];
+                            run.StageRuns[index] += statistics.StageRuns[index];
+                        }
+                    }
+                }
+            }
+            catch (...)
+            {
+                errors[threadIndex] = std::current_exception();
+                nextCompilation = compilations;
+            }
+        };
+
+        const auto start{std::chrono::steady_clock::now()};
+        if (threadCount == 1)
+        {
+            work(0);
+        }
+        else
+        {
+            std::vector<std::thread> threads{};
+            for (size_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+            {
+                threads.emplace_back(work, threadIndex);
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+        }
+        run.Elapsed = std::chrono::steady_clock::now() - start;
+
+        for (size_t threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            if (errors[threadIndex])
+            {
+                std::rethrow_exception(errors[threadIndex]);
+            }
+
+            run.LatenciesMilliseconds.insert(run.LatenciesMilliseconds.end(), latencies[threadIndex].begin(), latencies[threadIndex].end());
+        }
+
+        std::sort(run.LatenciesMilliseconds.begin(), run.LatenciesMilliseconds.end());
+        return run;
+    }
+
+    double GetPercentile(const std::vector<double>& sortedValues, double percentile)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sortedValues.size())));
+        return sortedValues[std::clamp<size_t>(rank, 1, sortedValues.size()) - 1];
+    }
+
+    void Report(const char* name, const Run& run)
+    {
+        std::printf("%s: %zu compilations in %.3f s, %.1f programs/s, p50 %.3f ms, p99 %.3f ms\n",
+            name,
+            run.LatenciesMilliseconds.size(),
+            run.Elapsed.count(),
+            static_cast<double>(run.LatenciesMilliseconds.size()) / run.Elapsed.count(),
+            GetPercentile(run.LatenciesMilliseconds, 50),
+            GetPercentile(run.LatenciesMilliseconds, 99));
+    }
+
+    // A program parsed and linked the same way the shader compiler does before modifying it, short of the SPIR-V
+    // settings, which only matter to the generation of SPIR-V.
+    class LinkedProgram final
+    {
+    public:
+        explicit LinkedProgram(const Program& program)
+        {
+            AddShader(program, m_vertexShader, program.VertexSource);
+            AddShader(program, m_fragmentShader, program.FragmentSource);
+
+            if (!m_program.link(EShMsgDefault))
+            {
+                throw std::runtime_error{program.GetName() + ": " + m_program.getInfoLog()};
+            }
+        }
+
+        LinkedProgram(const LinkedProgram&) = delete;
+
+        glslang::TProgram& Get()
+        {
+            return m_program;
+        }
+
+    private:
+        void AddShader(const Program& program, glslang::TShader& shader, const std::string& source)
+        {
+            const std::array<const char*, 1> sources{source.data()};
+            shader.setStrings(sources.data(), static_cast<int>(sources.size()));
+
+            if (!shader.parse(&Babylon::DefaultTBuiltInResource, 310, EProfile::EEsProfile, true, true, EShMsgDefault))
+            {
+                throw std::runtime_error{program.GetName() + ": " + shader.getInfoLog()};
+            }
+
+            m_program.addShader(&shader);
+        }
+
+        // Declared ahead of the shaders, as in the shader compiler.
+        glslang::TProgram m_program{};
+        glslang::TShader m_vertexShader{EShLangVertex};
+        glslang::TShader m_fragmentShader{EShLangFragment};
+    };
+
+    // Returns how long modifying the program took, either with the single traversal of ModifyProgram or with
+    // the individual modification functions, which traverse the program once each. Every modification is
+    // performed, as on Metal, regardless of the platform this tool is built for, so that every traversal is
+    // accounted for. Parsing and linking aren't measured.
+    std::chrono::nanoseconds TimeModifications(const Program& program, bool singleTraversal)
+    {
+        namespace Traversers = Babylon::ShaderCompilerTraversers;
+
+        LinkedProgram linkedProgram{program};
+        glslang::TProgram& linked{linkedProgram.Get()};
+        Traversers::IdGenerator ids{};
+        std::unordered_map<std::string, std::string> vertexAttributeRenaming{};
+        std::unordered_map<std::string, Babylon::ShaderCompiler::PackedUniform> packedUniforms{};
+        // The modified program references allocations of the scopes, which are only released after timing.
+        std::vector<Traversers::ScopeT> scopes{};
+
+        const auto start{std::chrono::steady_clock::now()};
+        if (singleTraversal)
+        {
+            Traversers::Modifications modifications{};
+            modifications.PackUniforms = true;
+            modifications.ChangeUniformTypes = true;
+            modifications.MoveNonSamplerUniformsIntoStruct = true;
+            modifications.SplitSamplersIntoSamplersAndTextures = true;
+            modifications.InvertYDerivativeOperands = true;
+
+            Babylon::ShaderCompiler::Statistics statistics{};
+            scopes.push_back(Traversers::ModifyProgram(linked, ids, modifications, vertexAttributeRenaming, packedUniforms, statistics));
+        }
+        else
+        {
+            Traversers::PackUniforms(linked, ids, packedUniforms);
+            scopes.push_back(Traversers::ChangeUniformTypes(linked, ids));
+            scopes.push_back(Traversers::MoveNonSamplerUniformsIntoStruct(linked, ids));
+            Traversers::AssignLocationsAndNamesToVertexVaryings(linked, ids, vertexAttributeRenaming);
+            Traversers::SplitSamplersIntoSamplersAndTextures(linked, ids);
+            Traversers::InvertYDerivativeOperands(linked);
+        }
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    double GetMedianMilliseconds(std::vector<std::chrono::nanoseconds>& durations)
+    {
+        std::sort(durations.begin(), durations.end());
+        return std::chrono::duration<double, std::milli>{durations[durations.size() / 2]}.count();
+    }
+
+    void CompareTraversals(const std::vector<Program>& programs, size_t iterations)
+    {
+        std::printf("Program modification, median of %zu iterations:\n", iterations);
+        std::printf("  %-60s %12s %12s %10s\n", "Program", "Separate", "Single", "Reduction");
+
+        double totalSeparate{0};
+        double totalSingle{0};
+        for (const auto& program : programs)
+        {
+            std::vector<std::chrono::nanoseconds> separate{};
+            std::vector<std::chrono::nanoseconds> single{};
+
+            // Alternated, so that both are equally affected by whatever else the machine is doing.
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                separate.push_back(TimeModifications(program, false));
+                single.push_back(TimeModifications(program, true));
+            }
+
+            const double separateMilliseconds{GetMedianMilliseconds(separate)};
+            const double singleMilliseconds{GetMedianMilliseconds(single)};
+            totalSeparate += separateMilliseconds;
+            totalSingle += singleMilliseconds;
+
+            std::printf("  %-60s %9.3f ms %9.3f ms %9.1f%%\n", program.GetName().c_str(), separateMilliseconds, singleMilliseconds, 100.0 * (1.0 - singleMilliseconds / separateMilliseconds));
+        }
+
+        std::printf("  %-60s %9.3f ms %9.3f ms %9.1f%%\n", "Total", totalSeparate, totalSingle, 100.0 * (1.0 - totalSingle / totalSeparate));
+    }
+
+    // In bytes.
+    size_t GetPeakMemoryUsage()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss);
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    struct Result
+    {
+        std::string Name;
+        double Value;
+        // Whether a larger value is an improvement, as for a throughput, rather than a regression, as for a
+        // latency.
+        bool HigherIsBetter;
+    };
+
+    // How the results were measured, which must match for results to be compared.
+    std::string GetSetup(size_t programCount, size_t iterations, size_t threadCount)
+    {
+        return std::to_string(programCount) + "-programs-" + std::to_string(iterations) + "-iterations-" + std::to_string(threadCount) + "-threads";
+    }
+
+    // Each line of a baseline holds the name of a result and its value, except for the first, which holds the
+    // setup the results were measured with.
+    void WriteBaseline(const std::string& path, const std::string& setup, const std::vector<Result>& results)
+    {
+        std::ofstream file{path, std::ios::trunc};
+        file << setup << "\n";
+        for (const auto& result : results)
+        {
+            file << result.Name << " " << result.Value << "\n";
+        }
+
+        if (!file)
+        {
+            throw std::runtime_error{"Unable to write " + path + "."};
+        }
+    }
+
+    // Returns whether no result is worse than in the baseline by more than the tolerance, in percent. Results
+    // missing from the baseline, such as ones added since it was written, aren't compared.
+    bool CompareToBaseline(const std::string& path, const std::string& setup, const std::vector<Result>& results, double tolerance)
+    {
+        std::istringstream lines{Babylon::ShaderManifest::ReadFile(path)};
+        std::string baselineSetup{};
+        std::unordered_map<std::string, double> baseline{};
+
+        std::string name{};
+        double value{};
+        if (lines >> baselineSetup)
+        {
+            while (lines >> name >> value)
+            {
+                baseline[name] = value;
+            }
+        }
+
+        if (!lines.eof())
+        {
+            throw std::runtime_error{path + ": malformed baseline."};
+        }
+
+        if (baselineSetup != setup)
+        {
+            std::printf("The baseline was measured with %s rather than %s, not comparing.\n", baselineSetup.c_str(), setup.c_str());
+            return true;
+        }
+
+        std::printf("Compared to the baseline, with a tolerance of %.1f%%:\n", tolerance);
+        bool passed{true};
+        for (const auto& result : results)
+        {
+            const auto entry = baseline.find(result.Name);
+            if (entry == baseline.end() || entry->second <= 0)
+            {
+                continue;
+            }
+
+            const double change{100.0 * (result.Value - entry->second) / entry->second};
+            const bool regressed{(result.HigherIsBetter ? -change : change) > tolerance};
+            passed = passed && !regressed;
+
+            std::printf("  %-40s %12.3f %12.3f %+9.1f%%%s\n", result.Name.c_str(), entry->second, result.Value, change, regressed ? " regressed" : "");
+        }
+
+        return passed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t iterations{20};
+    size_t threadCount{std::max<size_t>(std::thread::hardware_concurrency(), 2)};
+    bool compareTraversals{false};
+    std::string baselinePath{};
+    std::string writtenBaselinePath{};
+    double tolerance{10};
+    std::string manifestPath{};
+
+    for (int index = 1; index < argc; ++index)
+    {
+        const std::string argument{argv[index]};
+        if (argument == "--iterations" && index + 1 < argc)
+        {
+            iterations = std::stoul(argv[++index]);
+        }
+        else if (argument == "--threads" && index + 1 < argc)
+        {
+            threadCount = std::stoul(argv[++index]);
+        }
+        else if (argument == "--compare-traversals")
+        {
+            compareTraversals = true;
+        }
+        else if (argument == "--baseline" && index + 1 < argc)
+        {
+            baselinePath = argv[++index];
+        }
+        else if (argument == "--tolerance" && index + 1 < argc)
+        {
+            tolerance = std::stod(argv[++index]);
+        }
+        else if (argument == "--write-baseline" && index + 1 < argc)
+        {
+            writtenBaselinePath = argv[++index];
+        }
+        else if (manifestPath.empty())
+        {
+            manifestPath = argument;
+        }
+        else
+        {
+            manifestPath.clear();
+            break;
+        }
+    }
+
+    if (manifestPath.empty() || iterations == 0 || threadCount == 0 || tolerance < 0)
+    {
+        std::fprintf(stderr, "Usage: ShaderCompilerBenchmark [--iterations <count>] [--threads <count>] [--compare-traversals] [--baseline <file> [--tolerance <percent>]] [--write-baseline <file>] <manifest>\n");
+        return 1;
+    }
+
+    try
+    {
+        const std::vector<Program> programs{LoadPrograms(manifestPath)};
+        Babylon::ShaderCompiler compiler{};
+
+        // Compile each program once up front, so that failures are reported against the program and so that
+        // one-time initialization isn't measured.
+        for (const auto& program : programs)
+        {
+            try
+            {
+                compiler.Compile(program.VertexSource, program.FragmentSource);
+            }
+            catch (const std::exception& ex)
+            {
+                throw std::runtime_error{program.GetName() + ": " + ex.what()};
+            }
+        }
+
+        std::printf("%zu programs, %zu iterations\n", programs.size(), iterations);
+
+        const Run singleThreaded{Compile(compiler, programs, iterations, 1)};
+        Report("Single-threaded", singleThreaded);
+
+        const Run parallel{Compile(compiler, programs, iterations, threadCount)};
+        Report(("Parallel (" + std::to_string(threadCount) + " threads)").c_str(), parallel);
+
+        std::printf("Single-threaded time per step:\n");
+        const auto compilations = static_cast<double>(singleThreaded.LatenciesMilliseconds.size());
+        for (size_t index = 0; index < Babylon::ShaderCompiler::Statistics::StageCount; ++index)
+        {
+            if (singleThreaded.StageRuns[index] != 0)
+            {
+                const std::chrono::duration<double, std::milli> duration{singleThreaded.StageDurations[index]};
+                std::printf("  %-40s %.3f ms\n", Babylon::ShaderCompiler::Statistics::GetStageName(static_cast<Babylon::ShaderCompiler::Statistics::Stage>(index)), duration.count() / compilations);
+            }
+        }
+
+        const double peakMemoryMegabytes{static_cast<double>(GetPeakMemoryUsage()) / (1024.0 * 1024.0)};
+        std::printf("Peak memory: %.1f MB\n", peakMemoryMegabytes);
+
+        const std::string setup{GetSetup(programs.size(), iterations, threadCount)};
+        const std::vector<Result> results{
+            {"single-threaded-programs-per-second", static_cast<double>(singleThreaded.LatenciesMilliseconds.size()) / singleThreaded.Elapsed.count(), true},
+            {"single-threaded-p50-ms", GetPercentile(singleThreaded.LatenciesMilliseconds, 50), false},
+            {"single-threaded-p99-ms", GetPercentile(singleThreaded.LatenciesMilliseconds, 99), false},
+            {"parallel-programs-per-second", static_cast<double>(parallel.LatenciesMilliseconds.size()) / parallel.Elapsed.count(), true},
+            {"parallel-p99-ms", GetPercentile(parallel.LatenciesMilliseconds, 99), false},
+            {"peak-memory-mb", peakMemoryMegabytes, false},
+        };
+
+        if (!writtenBaselinePath.empty())
+        {
+            WriteBaseline(writtenBaselinePath, setup, results);
+        }
+
+        const bool passed{baselinePath.empty() || CompareToBaseline(baselinePath, setup, results, tolerance)};
+
+        // Last, so that it doesn't affect the peak memory usage reported for compilations.
+        if (compareTraversals)
+        {
+            CompareTraversals(programs, iterations);
+        }
+
+        if (!passed)
+        {
+            std::fprintf(stderr, "Regressed from the baseline by more than %.1f%%.\n", tolerance);
+            return 1;
+        }
+        return 0;
+    }
+    catch (const std::exception& ex)
+    {
+        std::fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+}
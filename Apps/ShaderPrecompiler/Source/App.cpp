@@ -0,0 +1,81 @@
+// Compiles the Babylon.js shader permutations listed in a manifest into a shader bundle which NativeEngine
+// can mount at startup (see Babylon::Plugins::NativeEngine::MountShaderBundle), so that it never has to
+// compile them at runtime. Shaders are compiled for the graphics API NativeEngine uses on the platform
+// this tool is built for.
+//
+// The manifest lists the vertex and fragment sources of each program, see Babylon::ShaderManifest.
+//
+// With --optimize, the shaders are run through the SPIR-V optimizer, and the number of SPIR-V instructions
+// of each stage with and without optimization is reported. The bundle is then only used by NativeEngines
+// which have shader optimization enabled as well. The optimizer must be built in, see
+// Babylon::ShaderCompiler::IsSpirvOptimizerAvailable.
+
+#include <ShaderBundle.h>
+#include <ShaderCache.h>
+#include <ShaderCompiler.h>
+#include <ShaderManifest.h>
+
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    const bool optimize{argc == 4 && std::string{argv[1]} == "--optimize"};
+    if (argc != 3 && !optimize)
+    {
+        std::fprintf(stderr, "Usage: ShaderPrecompiler [--optimize] <manifest> <output bundle>\n");
+        return 1;
+    }
+
+    const std::string manifestPath{argv[argc - 2]};
+    const std::string bundlePath{argv[argc - 1]};
+
+    try
+    {
+        Babylon::ShaderCompiler compiler{Babylon::ShaderCompiler::Options{optimize}};
+        Babylon::ShaderCompiler unoptimizedCompiler{};
+        std::vector<std::pair<uint64_t, Babylon::ShaderCompiler::BgfxShaderInfo>> shaders{};
+
+        for (const auto& program : Babylon::ShaderManifest::Load(manifestPath))
+        {
+            try
+            {
+                Babylon::ShaderCompiler::Statistics statistics{};
+                shaders.emplace_back(Babylon::ShaderCache::ComputeKey(program.VertexSource, program.FragmentSource, compiler.GetOptions()), compiler.Compile(program.VertexSource, program.FragmentSource, statistics));
+
+                if (optimize)
+                {
+                    Babylon::ShaderCompiler::Statistics unoptimizedStatistics{};
+                    unoptimizedCompiler.Compile(program.VertexSource, program.FragmentSource, unoptimizedStatistics);
+                    std::printf("%s: %u -> %u SPIR-V instructions\n", program.VertexPath.c_str(), unoptimizedStatistics.VertexSpirvInstructions, statistics.VertexSpirvInstructions);
+                    std::printf("%s: %u -> %u SPIR-V instructions\n", program.FragmentPath.c_str(), unoptimizedStatistics.FragmentSpirvInstructions, statistics.FragmentSpirvInstructions);
+                }
+            }
+            catch (const std::exception& ex)
+            {
+                throw std::runtime_error{program.GetName() + ": " + ex.what()};
+            }
+        }
+
+        const std::vector<uint8_t> bundle{Babylon::ShaderBundle::Build(shaders)};
+
+        std::ofstream file{bundlePath, std::ios::binary | std::ios::trunc};
+        if (!file || !file.write(reinterpret_cast<const char*>(bundle.data()), static_cast<std::streamsize>(bundle.size())))
+        {
+            throw std::runtime_error{"Unable to write " + bundlePath + "."};
+        }
+
+        std::printf("Compiled %zu programs into %s (%zu bytes).\n", shaders.size(), bundlePath.c_str(), bundle.size());
+        return 0;
+    }
+    catch (const std::exception& ex)
+    {
+        std::fprintf(stderr, "%s\n", ex.what());
+        return 1;
+    }
+}
@@ -107,8 +107,15 @@ namespace
     }
 }
 
-int main(int /*_argc*/, const char* const* /*_argv*/)
+int main(int _argc, const char* const* _argv)
 {
+    // Dumping the shaders of the validation scenes provides ShaderCompilerBenchmark with a corpus.
+    if (_argc == 3 && std::string{_argv[1]} == "--dump-shaders")
+    {
+        std::filesystem::create_directories(_argv[2]);
+        Babylon::Plugins::NativeEngine::DumpShaderSources(_argv[2]);
+    }
+
     XInitThreads();
     Display* display = XOpenDisplay(NULL);
 
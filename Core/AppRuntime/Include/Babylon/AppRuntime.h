@@ -20,7 +20,7 @@ namespace Babylon
         void Suspend();
         void Resume();
 
-        void Dispatch(std::function<void(Napi::Env)> callback);
+        void Dispatch(MoveOnlyFunction<void(Napi::Env)> callback, JsRuntime::DispatchPriority priority = JsRuntime::DispatchPriority::Normal);
 
     private:
         // These three methods are the mechanism by which platform- and JavaScript-specific
@@ -12,7 +12,7 @@ namespace Babylon
         : m_workQueue{std::make_unique<WorkQueue>([this] { RunPlatformTier(); }, unhandledExceptionHandler)}
     {
         Dispatch([this](Napi::Env env) {
-            JsRuntime::CreateForJavaScript(env, [this](auto func) { m_workQueue->Append(std::move(func)); });
+            JsRuntime::CreateForJavaScript(env, [this](auto func, auto priority) { m_workQueue->Append(std::move(func), priority); }, JsRuntime::DispatchThreading::Concurrent);
         });
     }
 
@@ -35,8 +35,8 @@ namespace Babylon
         m_workQueue->Resume();
     }
 
-    void AppRuntime::Dispatch(std::function<void(Napi::Env)> func)
+    void AppRuntime::Dispatch(MoveOnlyFunction<void(Napi::Env)> func, JsRuntime::DispatchPriority priority)
     {
-        m_workQueue->Append(std::move(func));
+        m_workQueue->Append(std::move(func), priority);
     }
 }
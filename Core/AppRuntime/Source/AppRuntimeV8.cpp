@@ -6,6 +6,8 @@
 #include <v8.h>
 #include <libplatform/libplatform.h>
 
+#include <mutex>
+
 namespace Babylon
 {
     namespace
@@ -30,18 +32,20 @@ namespace Babylon
 
             static void Initialize(const char* executablePath)
             {
-                if (s_module == nullptr)
-                {
+                // Several runtimes, such as those of workers, may start at the same time.
+                std::call_once(s_initializeFlag, [executablePath] {
                     s_module = std::make_unique<Module>(executablePath);
-                }
+                });
             }
 
         private:
             std::unique_ptr<v8::Platform> m_platform;
 
+            static std::once_flag s_initializeFlag;
             static std::unique_ptr<Module> s_module;
         };
 
+        std::once_flag Module::s_initializeFlag;
         std::unique_ptr<Module> Module::s_module;
     }
 
@@ -15,19 +15,26 @@ namespace Babylon
             Resume();
         }
 
-        m_cancelSource.cancel();
-        m_dispatcher.cancelled();
+        m_cancelled = true;
+        {
+            std::scoped_lock lock{m_sleepMutex};
+        }
+        m_sleepCondition.notify_one();
 
         m_thread.join();
+
+        // Work appended while the JavaScript thread was shutting down is dropped without being run.
+        Clear();
     }
 
     void WorkQueue::Suspend()
     {
+        // Suspension takes effect as soon as the work currently running completes, ahead of any other work.
         auto suspensionMutex = std::make_unique<std::mutex>();
         m_suspensionLock.emplace(*suspensionMutex);
         Append([suspensionMutex{std::move(suspensionMutex)}](Napi::Env) mutable {
             std::scoped_lock lock{*suspensionMutex};
-        });
+        }, JsRuntime::DispatchPriority::FrameCritical);
     }
 
     void WorkQueue::Resume()
@@ -38,14 +45,164 @@ namespace Babylon
     void WorkQueue::Run(Napi::Env env)
     {
         m_env = std::make_optional(env);
-        m_dispatcher.set_affinity(std::this_thread::get_id());
 
-        while (!m_cancelSource.cancelled())
+        while (!m_cancelled)
+        {
+            std::unique_ptr<WorkBase> work{Pop()};
+            if (!work)
+            {
+                Wait();
+                continue;
+            }
+
+            try
+            {
+                work->Invoke(m_env.value());
+            }
+            catch (...)
+            {
+                m_unhandledExceptionHandler(std::current_exception());
+            }
+        }
+
+        Clear();
+        m_env.reset();
+    }
+
+    void WorkQueue::Push(WorkBase* work, Lane& lane)
+    {
+        lane.Enqueue(work);
+
+        // Pairs with Wait: either the JavaScript thread sees the new work before going to sleep, or this
+        // sees that it is sleeping and wakes it up.
+        if (m_sleeping)
+        {
+            {
+                std::scoped_lock lock{m_sleepMutex};
+            }
+            m_sleepCondition.notify_one();
+        }
+    }
+
+    WorkQueue::WorkBase* WorkQueue::Pop()
+    {
+        Lane* selected{nullptr};
+        for (auto& lane : m_lanes)
+        {
+            if (lane.HasWork() && (selected == nullptr || lane.PassedOver >= StarvationLimit))
+            {
+                selected = &lane;
+            }
+        }
+
+        if (selected == nullptr)
+        {
+            return nullptr;
+        }
+
+        WorkBase* work = selected->Pop();
+        if (work == nullptr)
+        {
+            // A producer is in the middle of appending the selected work, which will be poppable shortly.
+            return nullptr;
+        }
+
+        for (auto& lane : m_lanes)
+        {
+            lane.PassedOver = (&lane == selected || !lane.HasWork()) ? 0 : lane.PassedOver + 1;
+        }
+
+        return work;
+    }
+
+    bool WorkQueue::HasWork() const
+    {
+        for (const auto& lane : m_lanes)
+        {
+            if (lane.HasWork())
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void WorkQueue::Wait()
+    {
+        std::unique_lock lock{m_sleepMutex};
+        m_sleeping = true;
+        m_sleepCondition.wait(lock, [this] { return m_cancelled || HasWork(); });
+        m_sleeping = false;
+    }
+
+    void WorkQueue::Clear()
+    {
+        for (auto& lane : m_lanes)
+        {
+            while (WorkBase* work = lane.Pop())
+            {
+                delete work;
+            }
+
+            lane.PassedOver = 0;
+        }
+    }
+
+    void WorkQueue::Lane::Enqueue(WorkBase* work)
+    {
+        work->Next.store(nullptr, std::memory_order_relaxed);
+        WorkBase* previous = Head.exchange(work);
+        // Until this store, the work is in the list but not reachable from the tail; HasWork treats that as
+        // the list not being empty yet.
+        previous->Next.store(work, std::memory_order_release);
+    }
+
+    WorkQueue::WorkBase* WorkQueue::Lane::Pop()
+    {
+        WorkBase* tail = Tail;
+        WorkBase* next = tail->Next.load(std::memory_order_acquire);
+
+        if (tail == &Stub)
+        {
+            if (next == nullptr)
+            {
+                return nullptr;
+            }
+
+            Tail = next;
+            tail = next;
+            next = next->Next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr)
+        {
+            Tail = next;
+            return tail;
+        }
+
+        if (tail != Head.load())
+        {
+            // A producer is in the middle of appending after the tail.
+            return nullptr;
+        }
+
+        // The tail is the last work in the list, which can only be popped once something follows it.
+        Enqueue(&Stub);
+
+        next = tail->Next.load(std::memory_order_acquire);
+        if (next != nullptr)
         {
-            m_dispatcher.blocking_tick(m_cancelSource);
+            Tail = next;
+            return tail;
         }
 
-        m_dispatcher.clear();
-        m_task = arcana::task_from_result<std::error_code>();
+        return nullptr;
+    }
+
+    bool WorkQueue::Lane::HasWork() const
+    {
+        // The list is only empty when both the head and the tail are back on the stub.
+        return Tail != &Stub || Head.load() != &Stub;
     }
 }
@@ -1,15 +1,34 @@
 #pragma once
 
-#include <arcana/threading/dispatcher.h>
-#include <arcana/threading/task.h>
+#include <Babylon/JsRuntime.h>
+
 #include <napi/env.h>
 
-#include <future>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 
 namespace Babylon
 {
+    // Queue of work to be run on the JavaScript thread. Any number of threads can append work, while only
+    // the JavaScript thread ever runs it.
+    //
+    // Work is appended to one lane per dispatch priority. The JavaScript thread always runs work from the
+    // highest priority lane that has any, except that a lane which was passed over StarvationLimit times in
+    // a row while it had work gets to run its next work regardless, so that lower priorities still make
+    // progress under a constant stream of higher priority work.
+    //
+    // Each lane is an intrusive multi-producer, single-consumer linked list (see
+    // http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue), so that
+    // appending only costs one allocation and one atomic exchange, without any lock being taken. The
+    // mutex and condition variable are only used to put the JavaScript thread to sleep when it runs out of
+    // work, and producers only touch them when it actually is asleep.
     class WorkQueue
     {
     public:
@@ -17,19 +36,9 @@ namespace Babylon
         ~WorkQueue();
 
         template<typename CallableT>
-        void Append(CallableT callable)
+        void Append(CallableT callable, JsRuntime::DispatchPriority priority = JsRuntime::DispatchPriority::Normal)
         {
-            std::scoped_lock lock{m_appendMutex};
-            m_task = m_task.then(m_dispatcher, m_cancelSource, [this, callable = std::move(callable)]() mutable noexcept {
-                try
-                {
-                    callable(m_env.value());
-                }
-                catch (...)
-                {
-                    m_unhandledExceptionHandler(std::current_exception());
-                }
-            });
+            Push(new Work<CallableT>{std::move(callable)}, m_lanes[static_cast<size_t>(priority)]);
         }
 
         void Suspend();
@@ -37,15 +46,66 @@ namespace Babylon
         void Run(Napi::Env);
 
     private:
-        std::optional<Napi::Env> m_env{};
+        struct WorkBase
+        {
+            virtual ~WorkBase() = default;
+            virtual void Invoke(Napi::Env) {}
+
+            std::atomic<WorkBase*> Next{nullptr};
+        };
+
+        template<typename CallableT>
+        struct Work final : WorkBase
+        {
+            Work(CallableT callable)
+                : Callable{std::move(callable)}
+            {
+            }
+
+            void Invoke(Napi::Env env) override
+            {
+                Callable(env);
+            }
 
-        std::mutex m_appendMutex{};
+            CallableT Callable;
+        };
+
+        // Producers append at the head, the JavaScript thread pops from the tail. The stub is a placeholder
+        // which lets the list never be empty, so that producers never need to touch the tail.
+        struct Lane
+        {
+            void Enqueue(WorkBase* work);
+            WorkBase* Pop();
+            // Only meaningful on the JavaScript thread. Also true while a producer is in the middle of
+            // appending, even though Pop can't return that work yet.
+            bool HasWork() const;
+
+            WorkBase Stub{};
+            std::atomic<WorkBase*> Head{&Stub};
+            WorkBase* Tail{&Stub};
+            // How many times in a row work from another lane was run while this one had work.
+            size_t PassedOver{0};
+        };
+
+        static constexpr size_t StarvationLimit{16};
+
+        void Push(WorkBase* work, Lane& lane);
+        WorkBase* Pop();
+        bool HasWork() const;
+        void Wait();
+        void Clear();
+
+        std::optional<Napi::Env> m_env{};
 
         std::optional<std::scoped_lock<std::mutex>> m_suspensionLock{};
 
-        arcana::cancellation_source m_cancelSource{};
-        arcana::task<void, std::error_code> m_task = arcana::task_from_result<std::error_code>();
-        arcana::manual_dispatcher<128> m_dispatcher{};
+        // Indexed by JsRuntime::DispatchPriority, from the highest priority to the lowest.
+        std::array<Lane, JsRuntime::DispatchPriorityCount> m_lanes{};
+
+        std::atomic<bool> m_cancelled{false};
+        std::atomic<bool> m_sleeping{false};
+        std::mutex m_sleepMutex{};
+        std::condition_variable m_sleepCondition{};
 
         std::thread m_thread;
 
@@ -3,6 +3,7 @@
 #include <Babylon/JsRuntime.h>
 
 #include <memory>
+#include <string>
 
 namespace Babylon
 {
@@ -36,6 +37,10 @@ namespace Babylon
 
         void SetDiagnosticOutput(std::function<void(const char* output)> outputFunction);
 
+        // Directory in which compiled shaders are cached across runs. Caching is disabled while it is empty,
+        // which is the default. The directory must exist.
+        void SetCacheDirectory(std::string directory);
+
         float GetHardwareScalingLevel();
         void SetHardwareScalingLevel(float level);
 
@@ -6,7 +6,10 @@
 #include <stdarg.h>
 #include <bgfx/bgfx.h>
 #include <Babylon/JsRuntime.h>
+#include <CacheUtils/CacheUtils.h>
 #include <assert.h>
+#include <fstream>
+#include <functional>
 
 namespace Babylon
 {
@@ -85,18 +88,65 @@ namespace Babylon
         m_outputFunction = std::move(outputFunction);
     }
 
-    uint32_t BgfxCallback::cacheReadSize(uint64_t /*id*/)
+    void BgfxCallback::SetCacheDirectory(std::string directory)
     {
-        return 0;
+        std::scoped_lock lock{m_cacheDirectoryAccess};
+        m_cacheDirectory = std::move(directory);
     }
 
-    bool BgfxCallback::cacheRead(uint64_t /*id*/, void* /*data*/, uint32_t /*size*/)
+    std::string BgfxCallback::GetCacheDirectory()
     {
-        return false;
+        std::scoped_lock lock{m_cacheDirectoryAccess};
+        return m_cacheDirectory;
     }
 
-    void BgfxCallback::cacheWrite(uint64_t /*id*/, const void* /*data*/, uint32_t /*size*/)
+    std::string BgfxCallback::GetCachePath(uint64_t id)
     {
+        const std::string directory{GetCacheDirectory()};
+        if (directory.empty())
+        {
+            return {};
+        }
+
+        char name[32];
+        bx::snprintf(name, sizeof(name), "/%016llx.bgfx", static_cast<unsigned long long>(id));
+        return directory + name;
+    }
+
+    uint32_t BgfxCallback::cacheReadSize(uint64_t id)
+    {
+        const std::string path{GetCachePath(id)};
+        if (path.empty())
+        {
+            return 0;
+        }
+
+        std::ifstream file{path, std::ios::binary | std::ios::ate};
+        return file ? static_cast<uint32_t>(file.tellg()) : 0;
+    }
+
+    bool BgfxCallback::cacheRead(uint64_t id, void* data, uint32_t size)
+    {
+        const std::string path{GetCachePath(id)};
+        if (path.empty())
+        {
+            return false;
+        }
+
+        std::ifstream file{path, std::ios::binary};
+        return file && file.read(static_cast<char*>(data), size) && file.gcount() == static_cast<std::streamsize>(size);
+    }
+
+    void BgfxCallback::cacheWrite(uint64_t id, const void* data, uint32_t size)
+    {
+        const std::string path{GetCachePath(id)};
+        if (path.empty())
+        {
+            return;
+        }
+
+        // cacheRead must never see a partially written program.
+        CacheUtils::WriteFileAtomically(path, data, size);
     }
 
     void BgfxCallback::screenShot(const char* /*filePath*/, uint32_t width, uint32_t height, uint32_t pitch, const void* data, uint32_t /*size*/, bool yflip)
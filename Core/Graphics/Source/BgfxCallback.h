@@ -9,6 +9,7 @@
 
 #include <mutex>
 #include <queue>
+#include <string>
 #include <vector>
 
 namespace Babylon
@@ -32,6 +33,10 @@ namespace Babylon
         void addScreenShotCallback(Napi::Function callback);
 
         void SetDiagnosticOutput(std::function<void(const char* output)> outputFunction);
+
+        // Directory in which bgfx caches compiled shader programs. The cache is disabled while it is empty.
+        void SetCacheDirectory(std::string directory);
+        std::string GetCacheDirectory();
     protected:
         void fatal(const char* filePath, uint16_t line, bgfx::Fatal::Enum code, const char* str) override;
         void traceVargs(const char* filePath, uint16_t line, const char* format, va_list argList) override;
@@ -48,6 +53,10 @@ namespace Babylon
         void trace(const char* _filePath, uint16_t _line, const char* _format, ...);
 
         std::function<void(const char* output)> m_outputFunction;
+
+        std::string GetCachePath(uint64_t id);
+        std::mutex m_cacheDirectoryAccess;
+        std::string m_cacheDirectory;
         
         std::mutex m_ssCallbackAccess;
         std::queue<Napi::FunctionReference> m_screenshotCallbacks;
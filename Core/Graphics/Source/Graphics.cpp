@@ -77,6 +77,11 @@ namespace Babylon
         m_impl->SetDiagnosticOutput(std::move(outputFunction));
     }
 
+    void Graphics::SetCacheDirectory(std::string directory)
+    {
+        m_impl->SetCacheDirectory(std::move(directory));
+    }
+
     void Graphics::SetHardwareScalingLevel(float level)
     {
         m_impl->SetHardwareScalingLevel(level);
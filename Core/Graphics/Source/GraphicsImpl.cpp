@@ -244,6 +244,16 @@ namespace Babylon
         Callback.SetDiagnosticOutput(std::move(outputFunction));
     }
 
+    void Graphics::Impl::SetCacheDirectory(std::string directory)
+    {
+        Callback.SetCacheDirectory(std::move(directory));
+    }
+
+    std::string Graphics::Impl::GetCacheDirectory()
+    {
+        return Callback.GetCacheDirectory();
+    }
+
     float Graphics::Impl::GetHardwareScalingLevel()
     {
         std::scoped_lock lock{m_state.Mutex};
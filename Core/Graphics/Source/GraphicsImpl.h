@@ -45,6 +45,9 @@ namespace Babylon
 
         void SetDiagnosticOutput(std::function<void(const char* output)> outputFunction);
 
+        void SetCacheDirectory(std::string directory);
+        std::string GetCacheDirectory();
+
         float GetHardwareScalingLevel();
         void SetHardwareScalingLevel(float level);
 
@@ -1,9 +1,10 @@
 #pragma once
 
+#include "MoveOnlyFunction.h"
+
 #include <napi/env.h>
 
 #include <functional>
-#include <mutex>
 
 namespace Babylon
 {
@@ -25,16 +26,48 @@ namespace Babylon
         struct InternalState;
         friend struct InternalState;
 
-        using DispatchFunctionT = std::function<void(std::function<void(Napi::Env)>)>;
+        // The order in which dispatched work should run relative to other dispatched work. Work of a
+        // higher priority runs first, though dispatch functions should make sure that work of a lower
+        // priority still eventually runs when work of a higher priority keeps coming in. Work of the same
+        // priority runs in the order it was dispatched.
+        enum class DispatchPriority
+        {
+            // Work which a frame is waiting on, such as rendering and requestAnimationFrame callbacks.
+            FrameCritical,
+            // Input events.
+            Input,
+            // Everything else, unless it is known to be expendable.
+            Normal,
+            // Work which can wait without the user noticing, such as completions of asset loads.
+            Background,
+        };
+
+        static constexpr size_t DispatchPriorityCount{4};
+
+        using DispatchFunctionT = std::function<void(MoveOnlyFunction<void(Napi::Env)>, DispatchPriority)>;
+
+        // The dispatch function of earlier versions, which gets neither priorities nor move-only work. Work
+        // dispatched through it runs in the order it was dispatched, whatever its priority.
+        using UnprioritizedDispatchFunctionT = std::function<void(std::function<void(Napi::Env)>)>;
+
+        // Whether JsRuntime must make sure that its dispatch function is only called by one thread
+        // at a time, as it always has, or whether the dispatch function is safely callable from any
+        // number of threads at once, in which case JsRuntime calls it without taking a lock.
+        enum class DispatchThreading
+        {
+            Serialized,
+            Concurrent,
+        };
 
         // Note: It is the contract of JsRuntime that its dispatch function must be usable
         // at the moment of construction. JsRuntime cannot be built with dispatch function
         // that captures a refence to a not-yet-completed object that will be completed
         // later -- an instance of an inheriting type, for example. The dispatch function
         // must be safely callable as soon as it is passed to the JsRuntime constructor.
-        static JsRuntime& CreateForJavaScript(Napi::Env, DispatchFunctionT);
+        static JsRuntime& CreateForJavaScript(Napi::Env, DispatchFunctionT, DispatchThreading threading = DispatchThreading::Serialized);
+        static JsRuntime& CreateForJavaScript(Napi::Env, UnprioritizedDispatchFunctionT);
         static JsRuntime& GetFromJavaScript(Napi::Env);
-        void Dispatch(std::function<void(Napi::Env)>);
+        void Dispatch(MoveOnlyFunction<void(Napi::Env)>, DispatchPriority priority = DispatchPriority::Normal);
 
     protected:
         JsRuntime(const JsRuntime&) = delete;
@@ -44,7 +77,6 @@ namespace Babylon
         JsRuntime(Napi::Env, DispatchFunctionT);
 
         DispatchFunctionT m_dispatchFunction{};
-        std::mutex m_mutex{};
 
         std::unique_ptr<InternalState> m_internalState{};
     };
@@ -5,26 +5,28 @@
 namespace Babylon
 {
     /**
-     * Scheduler that invokes continuations via JsRuntime::Dispatch.
+     * Scheduler that invokes continuations via JsRuntime::Dispatch, with the given priority.
      * Intended to be consumed by arcana.cpp tasks.
      */
     class JsRuntimeScheduler
     {
     public:
-        explicit JsRuntimeScheduler(JsRuntime& runtime)
+        explicit JsRuntimeScheduler(JsRuntime& runtime, JsRuntime::DispatchPriority priority = JsRuntime::DispatchPriority::Normal)
             : m_runtime{runtime}
+            , m_priority{priority}
         {
         }
 
         template<typename CallableT>
         void operator()(CallableT&& callable) const
         {
-            m_runtime.Dispatch([callable{std::forward<CallableT>(callable)}](Napi::Env){
+            m_runtime.Dispatch([callable{std::forward<CallableT>(callable)}](Napi::Env) mutable {
                 callable();
-            });
+            }, m_priority);
         }
 
     private:
         JsRuntime& m_runtime;
+        JsRuntime::DispatchPriority m_priority;
     };
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Babylon
+{
+    // Holds any callable with the given signature, like std::function, except that:
+    // - the callable only needs to be movable, so lambdas can capture std::unique_ptrs, Napi references and
+    //   the like without being wrapped in std::shared_ptrs;
+    // - callables of up to InlineSize bytes which can be moved without throwing are stored in place rather
+    //   than on the heap, which covers the lambdas passed to the various Dispatch methods.
+    // The default size makes the whole object one cache line on 64-bit platforms.
+    template<typename SignatureT, size_t InlineSize = 7 * sizeof(void*)>
+    class MoveOnlyFunction;
+
+    template<typename ReturnT, typename... ArgsT, size_t InlineSize>
+    class MoveOnlyFunction<ReturnT(ArgsT...), InlineSize> final
+    {
+    public:
+        MoveOnlyFunction() = default;
+
+        MoveOnlyFunction(std::nullptr_t)
+        {
+        }
+
+        template<typename CallableT, typename = std::enable_if_t<!std::is_same_v<std::decay_t<CallableT>, MoveOnlyFunction> && std::is_invocable_r_v<ReturnT, std::decay_t<CallableT>&, ArgsT...>>>
+        MoveOnlyFunction(CallableT&& callable)
+        {
+            using StoredT = std::decay_t<CallableT>;
+            if constexpr (IsStoredInline<StoredT>())
+            {
+                new (&m_storage) StoredT(std::forward<CallableT>(callable));
+                m_operations = GetInlineOperations<StoredT>();
+            }
+            else
+            {
+                new (&m_storage) StoredT*(new StoredT(std::forward<CallableT>(callable)));
+                m_operations = GetHeapOperations<StoredT>();
+            }
+        }
+
+        MoveOnlyFunction(MoveOnlyFunction&& other) noexcept
+        {
+            MoveFrom(other);
+        }
+
+        MoveOnlyFunction(const MoveOnlyFunction&) = delete;
+
+        ~MoveOnlyFunction()
+        {
+            Reset();
+        }
+
+        MoveOnlyFunction& operator=(MoveOnlyFunction&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                MoveFrom(other);
+            }
+
+            return *this;
+        }
+
+        MoveOnlyFunction& operator=(const MoveOnlyFunction&) = delete;
+
+        MoveOnlyFunction& operator=(std::nullptr_t) noexcept
+        {
+            Reset();
+            return *this;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_operations != nullptr;
+        }
+
+        // Like std::function, calls the callable as non-const even though the call operator is const, so that
+        // it can be called from within lambdas which aren't mutable.
+        ReturnT operator()(ArgsT... args) const
+        {
+            if (m_operations == nullptr)
+            {
+                throw std::bad_function_call{};
+            }
+
+            return m_operations->Invoke(&m_storage, std::forward<ArgsT>(args)...);
+        }
+
+    private:
+        struct Operations
+        {
+            ReturnT (*Invoke)(void* storage, ArgsT&&... args);
+            // Moves the callable to the destination and destroys what is left in the source.
+            void (*Move)(void* source, void* destination) noexcept;
+            void (*Destroy)(void* storage) noexcept;
+        };
+
+        template<typename StoredT>
+        static constexpr bool IsStoredInline()
+        {
+            return sizeof(StoredT) <= InlineSize && alignof(StoredT) <= alignof(void*) && std::is_nothrow_move_constructible_v<StoredT>;
+        }
+
+        template<typename StoredT>
+        static const Operations* GetInlineOperations()
+        {
+            static constexpr Operations operations{
+                [](void* storage, ArgsT&&... args) -> ReturnT {
+                    return std::invoke(*static_cast<StoredT*>(storage), std::forward<ArgsT>(args)...);
+                },
+                [](void* source, void* destination) noexcept {
+                    new (destination) StoredT(std::move(*static_cast<StoredT*>(source)));
+                    static_cast<StoredT*>(source)->~StoredT();
+                },
+                [](void* storage) noexcept {
+                    static_cast<StoredT*>(storage)->~StoredT();
+                }};
+            return &operations;
+        }
+
+        template<typename StoredT>
+        static const Operations* GetHeapOperations()
+        {
+            static constexpr Operations operations{
+                [](void* storage, ArgsT&&... args) -> ReturnT {
+                    return std::invoke(**static_cast<StoredT**>(storage), std::forward<ArgsT>(args)...);
+                },
+                [](void* source, void* destination) noexcept {
+                    new (destination) StoredT*(*static_cast<StoredT**>(source));
+                },
+                [](void* storage) noexcept {
+                    delete *static_cast<StoredT**>(storage);
+                }};
+            return &operations;
+        }
+
+        void MoveFrom(MoveOnlyFunction& other) noexcept
+        {
+            if (other.m_operations != nullptr)
+            {
+                other.m_operations->Move(&other.m_storage, &m_storage);
+                m_operations = other.m_operations;
+                other.m_operations = nullptr;
+            }
+        }
+
+        void Reset() noexcept
+        {
+            if (m_operations != nullptr)
+            {
+                m_operations->Destroy(&m_storage);
+                m_operations = nullptr;
+            }
+        }
+
+        alignas(void*) mutable unsigned char m_storage[InlineSize];
+        const Operations* m_operations{nullptr};
+    };
+}
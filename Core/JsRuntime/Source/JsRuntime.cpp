@@ -1,6 +1,9 @@
 #include "JsRuntime.h"
 #include "JsRuntimeInternalState.h"
 
+#include <memory>
+#include <mutex>
+
 namespace Babylon
 {
     namespace
@@ -27,12 +30,31 @@ namespace Babylon
         jsNative.Set(JS_RUNTIME_NAME, jsRuntime);
     }
 
-    JsRuntime& JsRuntime::CreateForJavaScript(Napi::Env env, DispatchFunctionT dispatchFunction)
+    JsRuntime& JsRuntime::CreateForJavaScript(Napi::Env env, DispatchFunctionT dispatchFunction, DispatchThreading threading)
     {
+        if (threading == DispatchThreading::Serialized)
+        {
+            // std::function only holds copyable callables, hence the shared mutex.
+            dispatchFunction = [dispatchFunction{std::move(dispatchFunction)}, mutex{std::make_shared<std::mutex>()}](MoveOnlyFunction<void(Napi::Env)> function, DispatchPriority priority) {
+                std::scoped_lock lock{*mutex};
+                dispatchFunction(std::move(function), priority);
+            };
+        }
+
         auto* runtime = new JsRuntime(env, std::move(dispatchFunction));
         return *runtime;
     }
 
+    JsRuntime& JsRuntime::CreateForJavaScript(Napi::Env env, UnprioritizedDispatchFunctionT dispatchFunction)
+    {
+        return CreateForJavaScript(env, [dispatchFunction{std::move(dispatchFunction)}](MoveOnlyFunction<void(Napi::Env)> function, DispatchPriority) {
+            // std::function only holds copyable callables.
+            dispatchFunction([function{std::make_shared<MoveOnlyFunction<void(Napi::Env)>>(std::move(function))}](Napi::Env functionEnv) {
+                (*function)(functionEnv);
+            });
+        });
+    }
+
     JsRuntime& JsRuntime::GetFromJavaScript(Napi::Env env)
     {
         return *NativeObject::GetFromJavaScript(env)
@@ -42,9 +64,8 @@ namespace Babylon
                     .Data();
     }
 
-    void JsRuntime::Dispatch(std::function<void(Napi::Env)> function)
+    void JsRuntime::Dispatch(MoveOnlyFunction<void(Napi::Env)> function, DispatchPriority priority)
     {
-        std::scoped_lock lock{m_mutex};
-        m_dispatchFunction(std::move(function));
+        m_dispatchFunction(std::move(function), priority);
     }
 }
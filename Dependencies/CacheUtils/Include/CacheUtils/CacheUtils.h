@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CacheUtils
+{
+    constexpr uint64_t Fnv1aOffsetBasis{UINT64_C(0xCBF29CE484222325)};
+
+    // 64-bit FNV-1a. Data hashed in several parts gets the hash of the previous parts as its starting value.
+    inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = Fnv1aOffsetBasis)
+    {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t index = 0; index < size; ++index)
+        {
+            hash ^= bytes[index];
+            hash *= UINT64_C(0x100000001B3);
+        }
+        return hash;
+    }
+
+    // Writes the file under a temporary name unique across threads and processes, then renames it, so that
+    // concurrent writers of the same file, possibly from other processes, never let a reader see a partially
+    // written file. Returns false if the file couldn't be written, which leaves no temporary file behind.
+    // Losing the race to another writer counts as success, since the file then holds what the other wrote.
+    bool WriteFileAtomically(const std::string& path, const void* data, size_t size);
+}
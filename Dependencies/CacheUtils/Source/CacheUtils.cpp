@@ -0,0 +1,50 @@
+#include <CacheUtils/CacheUtils.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace CacheUtils
+{
+    bool WriteFileAtomically(const std::string& path, const void* data, size_t size)
+    {
+        // Thread ids are only unique within a process, hence the process id.
+#ifdef _WIN32
+        const auto processId{_getpid()};
+#else
+        const auto processId{getpid()};
+#endif
+        static std::atomic<uint32_t> s_temporaryIndex{0};
+        const std::string temporaryPath{path + "." + std::to_string(processId) + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "." + std::to_string(s_temporaryIndex++) + ".tmp"};
+
+        {
+            std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+            if (!file)
+            {
+                return false;
+            }
+
+            if (!file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size)))
+            {
+                file.close();
+                std::remove(temporaryPath.c_str());
+                return false;
+            }
+        }
+
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            // Most likely another writer got there first, which is just as good.
+            std::remove(temporaryPath.c_str());
+        }
+        return true;
+    }
+}
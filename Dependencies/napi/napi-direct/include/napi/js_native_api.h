@@ -447,6 +447,11 @@ NAPI_EXTERN napi_status napi_adjust_external_memory(napi_env env,
                                                     int64_t change_in_bytes,
                                                     int64_t* adjusted_value);
 
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+NAPI_EXTERN napi_status napi_detach_arraybuffer(napi_env env,
+                                                napi_value arraybuffer);
+#endif  // NAPI_HAS_DETACH_ARRAYBUFFER
+
 #ifdef NAPI_EXPERIMENTAL
 
 NAPI_EXTERN napi_status napi_create_bigint_int64(napi_env env,
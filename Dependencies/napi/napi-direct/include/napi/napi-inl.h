@@ -1366,6 +1366,15 @@ inline size_t ArrayBuffer::ByteLength() const {
   return _length;
 }
 
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+inline void ArrayBuffer::Detach() {
+  napi_status status = napi_detach_arraybuffer(_env, _value);
+  NAPI_THROW_IF_FAILED_VOID(_env, status);
+  _data = nullptr;
+  _length = 0;
+}
+#endif
+
 inline void ArrayBuffer::EnsureInfo() const {
   // The ArrayBuffer instance may have been constructed from a napi_value whose
   // length/data are not yet known. Fetch and cache these values just once,
@@ -799,6 +799,12 @@ namespace Napi {
     void* Data() const;        ///< Gets a pointer to the data buffer.
     size_t ByteLength() const; ///< Gets the length of the array buffer in bytes.
 
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+    /// Detaches the array buffer, which leaves it empty. Only array buffers over external data can be
+    /// detached.
+    void Detach();
+#endif
+
   private:
     mutable void* _data;
     mutable size_t _length;
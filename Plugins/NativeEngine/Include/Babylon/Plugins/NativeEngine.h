@@ -4,7 +4,62 @@
 
 #include <napi/env.h>
 
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace Babylon::Plugins::NativeEngine
 {
     void Initialize(Napi::Env env, bool renderAutomatically = true);
+
+    // Makes NativeEngines created afterwards run the SPIR-V optimizer on the shaders they compile, trading
+    // compile time for smaller and faster shaders. Throws if glslang isn't built with ENABLE_OPT and SPIRV-Tools.
+    void EnableShaderOptimization(bool enabled);
+
+    // Makes the shaders of a bundle built by the ShaderPrecompiler tool available to every NativeEngine of the
+    // process, which then never compile the programs it contains. Throws if the file isn't a valid bundle.
+    void MountShaderBundle(const std::string& path);
+
+    // Makes every NativeEngine of the process write the sources of the programs created from then on to the
+    // directory, which must exist, along with a manifest.txt listing them in the format read by the
+    // ShaderPrecompiler and ShaderCompilerBenchmark tools. Each program is written once, even across runs
+    // dumping to the same directory. An empty directory stops dumping.
+    void DumpShaderSources(const std::string& directory);
+
+    // Where the time spent compiling shaders went, across all the NativeEngine instances of the process. Only
+    // programs actually compiled are accounted for; those found in a shader bundle or the shader cache are not.
+    struct ShaderCompilationProfile
+    {
+        struct Stage
+        {
+            std::string Name{};
+            // The number of times the stage ran, which is twice per compilation for the stages done once per
+            // shader stage.
+            uint32_t Count{};
+            std::chrono::nanoseconds TotalDuration{};
+            std::chrono::nanoseconds MaxDuration{};
+        };
+
+        struct Shader
+        {
+            // The value of the vertex shader's SHADER_NAME define, which Babylon.js sets to the name of the
+            // effect, if it has one.
+            std::string Name{};
+            // The key of the program in the shader cache and shader bundles.
+            uint64_t Key{};
+            std::chrono::nanoseconds Duration{};
+            // The duration of each of the Stages.
+            std::vector<std::chrono::nanoseconds> StageDurations{};
+        };
+
+        uint32_t Compilations{};
+        std::chrono::nanoseconds TotalDuration{};
+        std::vector<Stage> Stages{};
+        // The slowest programs to compile, slowest first.
+        std::vector<Shader> SlowestShaders{};
+    };
+
+    ShaderCompilationProfile GetShaderCompilationProfile();
+    void ResetShaderCompilationProfile();
 }
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <napi/napi.h>
+
+#include <gsl/gsl>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace Babylon
+{
+    // Commands understood by NativeEngine::SubmitCommands. A command buffer is a sequence of 32-bit words:
+    // each command is its opcode followed by its arguments, one word per argument, except for 64-bit
+    // integers which take two words, low word first. Floats are stored as their IEEE 754 bit pattern,
+    // booleans as 0 or 1, and native objects (programs, uniforms, textures, vertex arrays) as an index into
+    // the object table submitted alongside the command buffer. Commands taking a variable number of values
+    // are followed by a count and then by that many values.
+    enum class Command : uint32_t
+    {
+        SetProgram,         // program
+        SetState,           // culling, zOffset, cullBackFaces, reverseSide
+        SetDepthTest,       // depthTest
+        SetDepthWrite,      // enable
+        SetColorWrite,      // enable
+        SetBlendMode,       // blendMode (64-bit)
+        SetInt,             // uniform, int32
+        SetIntArray,        // uniform, count, int32 * count
+        SetIntArray2,       // uniform, count, int32 * count
+        SetIntArray3,       // uniform, count, int32 * count
+        SetIntArray4,       // uniform, count, int32 * count
+        SetFloat,           // uniform, float
+        SetFloat2,          // uniform, float * 2
+        SetFloat3,          // uniform, float * 3
+        SetFloat4,          // uniform, float * 4
+        SetFloatArray,      // uniform, count, float * count
+        SetFloatArray2,     // uniform, count, float * count
+        SetFloatArray3,     // uniform, count, float * count
+        SetFloatArray4,     // uniform, count, float * count
+        SetMatrix,          // uniform, float * 16
+        SetMatrix3x3,       // uniform, float * 9
+        SetMatrix2x2,       // uniform, float * 4
+        SetMatrices,        // uniform, count, float * count
+        SetTexture,         // uniform, texture
+        BindVertexArray,    // vertexArray
+        DrawIndexed,        // fillMode, elementStart, elementCount
+        Draw,               // fillMode, verticesStart, verticesCount
+        MultiDrawIndexed,   // fillMode, count, (elementStart, elementCount) * count / 2
+        Count
+    };
+
+    // The native objects which commands can reference, along with their types. N-API externals don't carry
+    // the type of what they point to, so the objects of the object table are looked up here, and any object
+    // which isn't registered, or is registered with another type, is rejected rather than reinterpreted.
+    class CommandObjectRegistry final
+    {
+    public:
+        using Type = const void*;
+
+        template<typename T>
+        static Type TypeOf()
+        {
+            // Each instantiation has its own variable, whose address identifies the type.
+            static const char type{};
+            return &type;
+        }
+
+        template<typename T>
+        void Add(const T* object)
+        {
+            m_objects[object] = TypeOf<T>();
+        }
+
+        void Remove(const void* object)
+        {
+            m_objects.erase(object);
+        }
+
+        // Returns the type the object was registered with, or null if it isn't registered.
+        Type Find(const void* object) const
+        {
+            const auto it = m_objects.find(object);
+            return it == m_objects.end() ? nullptr : it->second;
+        }
+
+    private:
+        std::unordered_map<const void*, Type> m_objects{};
+    };
+
+    class CommandBufferReader final
+    {
+    public:
+        CommandBufferReader(const Napi::Value& commands, const Napi::Value& objects, const CommandObjectRegistry& registry)
+        {
+            const Napi::Env env = commands.Env();
+
+            const uint8_t* bytes{};
+            size_t byteLength{};
+            if (commands.IsArrayBuffer())
+            {
+                const auto arrayBuffer = commands.As<Napi::ArrayBuffer>();
+                bytes = static_cast<const uint8_t*>(arrayBuffer.Data());
+                byteLength = arrayBuffer.ByteLength();
+            }
+            else if (commands.IsTypedArray())
+            {
+                const auto typedArray = commands.As<Napi::TypedArray>();
+                bytes = static_cast<const uint8_t*>(typedArray.ArrayBuffer().Data()) + typedArray.ByteOffset();
+                byteLength = typedArray.ByteLength();
+            }
+            else
+            {
+                throw Napi::Error::New(env, "Command buffer must be an ArrayBuffer or a typed array.");
+            }
+
+            if (byteLength % sizeof(uint32_t) != 0)
+            {
+                throw Napi::Error::New(env, "Command buffer length must be a multiple of 4 bytes.");
+            }
+
+            // Words are read in place, so a view at an offset which isn't a multiple of 4 can't be read.
+            if (reinterpret_cast<uintptr_t>(bytes) % alignof(uint32_t) != 0)
+            {
+                throw Napi::Error::New(env, "Command buffer must start at a multiple of 4 bytes.");
+            }
+
+            m_words = reinterpret_cast<const uint32_t*>(bytes);
+            m_size = byteLength / sizeof(uint32_t);
+
+            // Resolve the object table once up front so the decode loop never has to call back into JavaScript.
+            if (objects.IsArray())
+            {
+                const auto objectArray = objects.As<Napi::Array>();
+                const uint32_t length = objectArray.Length();
+                m_objects.reserve(length);
+                for (uint32_t index = 0; index < length; ++index)
+                {
+                    const Napi::Value value = objectArray[index];
+                    void* object = value.IsExternal() ? value.As<Napi::External<void>>().Data() : nullptr;
+                    m_objects.push_back({object, registry.Find(object)});
+                }
+            }
+        }
+
+        bool HasMore() const
+        {
+            return m_position < m_size;
+        }
+
+        size_t Position() const
+        {
+            return m_position;
+        }
+
+        uint32_t ReadUint32()
+        {
+            EnsureAvailable(1);
+            return m_words[m_position++];
+        }
+
+        uint64_t ReadUint64()
+        {
+            const uint64_t low = ReadUint32();
+            const uint64_t high = ReadUint32();
+            return low | (high << 32);
+        }
+
+        int32_t ReadInt32()
+        {
+            return static_cast<int32_t>(ReadUint32());
+        }
+
+        bool ReadBoolean()
+        {
+            return ReadUint32() != 0;
+        }
+
+        float ReadFloat32()
+        {
+            const uint32_t word = ReadUint32();
+            float value;
+            std::memcpy(&value, &word, sizeof(value));
+            return value;
+        }
+
+        // Returns a view over the next count words without copying them.
+        template<typename T>
+        gsl::span<const T> ReadSpan(size_t count)
+        {
+            static_assert(sizeof(T) == sizeof(uint32_t));
+            EnsureAvailable(count);
+            const auto* data = reinterpret_cast<const T*>(m_words + m_position);
+            m_position += count;
+            return gsl::make_span(data, count);
+        }
+
+        template<typename T>
+        T& ReadObject()
+        {
+            const uint32_t index = ReadUint32();
+            if (index >= m_objects.size() || m_objects[index].Type != CommandObjectRegistry::TypeOf<T>())
+            {
+                throw std::runtime_error{"Command buffer references an invalid object."};
+            }
+            return *static_cast<T*>(m_objects[index].Object);
+        }
+
+    private:
+        void EnsureAvailable(size_t count) const
+        {
+            if (m_size - m_position < count)
+            {
+                throw std::runtime_error{"Command buffer is truncated."};
+            }
+        }
+
+        const uint32_t* m_words{};
+        size_t m_size{0};
+        size_t m_position{0};
+        struct TableEntry
+        {
+            void* Object;
+            CommandObjectRegistry::Type Type;
+        };
+
+        std::vector<TableEntry> m_objects{};
+    };
+}
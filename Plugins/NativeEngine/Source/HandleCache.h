@@ -0,0 +1,130 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <CacheUtils/CacheUtils.h>
+
+#include <gsl/gsl>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+namespace Babylon
+{
+    // Shares bgfx handles between all the users of identical resources, which are identified by a key.
+    // Handles are reference counted and destroyed once no longer used.
+    template<typename HandleT, typename KeyT, typename KeyHashT = std::hash<KeyT>, typename KeyEqualT = std::equal_to<KeyT>>
+    class HandleCache final
+    {
+    public:
+        HandleCache() = default;
+        HandleCache(const HandleCache&) = delete;
+
+        ~HandleCache()
+        {
+            Clear();
+        }
+
+        // Returns the handle of the resource with the given key, calling createHandle to create it if there
+        // is none. Each call must be matched by a call to Release.
+        template<typename CreateHandleT>
+        HandleT Acquire(const KeyT& key, CreateHandleT&& createHandle)
+        {
+            auto it = m_entries.find(key);
+            if (it == m_entries.end())
+            {
+                const HandleT handle = createHandle();
+                it = m_entries.emplace(key, Entry{handle, 0}).first;
+                // Unlike iterators, pointers to the elements of an unordered_map survive rehashing.
+                m_keys[handle.idx] = &it->first;
+            }
+
+            ++it->second.RefCount;
+            return it->second.Handle;
+        }
+
+        void Release(HandleT handle)
+        {
+            const auto key = m_keys.find(handle.idx);
+            if (key == m_keys.end())
+            {
+                // The cache was cleared while the handle was still in use.
+                return;
+            }
+
+            const auto it = m_entries.find(*key->second);
+            if (--it->second.RefCount == 0)
+            {
+                bgfx::destroy(handle);
+                m_keys.erase(key);
+                m_entries.erase(it);
+            }
+        }
+
+        // Destroys all handles regardless of their reference counts. Must be called before bgfx::shutdown.
+        void Clear()
+        {
+            for (const auto& entry : m_entries)
+            {
+                bgfx::destroy(entry.second.Handle);
+            }
+            m_keys.clear();
+            m_entries.clear();
+        }
+
+        // The number of distinct resources currently alive.
+        size_t Size() const
+        {
+            return m_entries.size();
+        }
+
+    private:
+        struct Entry
+        {
+            HandleT Handle;
+            uint32_t RefCount;
+        };
+
+        std::unordered_map<KeyT, Entry, KeyHashT, KeyEqualT> m_entries{};
+        std::unordered_map<uint16_t, const KeyT*> m_keys{};
+    };
+
+    struct VertexLayoutHash
+    {
+        size_t operator()(const bgfx::VertexLayout& layout) const
+        {
+            // As computed by bgfx::VertexLayout::end.
+            return layout.m_hash;
+        }
+    };
+
+    struct VertexLayoutEqual
+    {
+        bool operator()(const bgfx::VertexLayout& left, const bgfx::VertexLayout& right) const
+        {
+            return left.m_stride == right.m_stride &&
+                std::memcmp(left.m_offset, right.m_offset, sizeof(left.m_offset)) == 0 &&
+                std::memcmp(left.m_attributes, right.m_attributes, sizeof(left.m_attributes)) == 0;
+        }
+    };
+
+    // Shares vertex layout handles between all the vertex buffers using identical layouts, which must have
+    // been ended. bgfx only supports a limited number of layout handles (BGFX_CONFIG_MAX_VERTEX_LAYOUTS),
+    // which large scenes would otherwise exhaust with duplicates.
+    using VertexLayoutCache = HandleCache<bgfx::VertexLayoutHandle, bgfx::VertexLayout, VertexLayoutHash, VertexLayoutEqual>;
+
+    // Shares shader handles between all the programs using identical shader stages. Babylon.js materials
+    // commonly differ in only one of their stages, so without sharing, bgfx (and the driver underneath it)
+    // would create and compile the same shader once per program. Shaders are keyed by GetShaderKey rather
+    // than by their bytes, which would double the memory they take; as for the shader cache, a collision of
+    // 64-bit hashes is not worth guarding against.
+    using ShaderHandleCache = HandleCache<bgfx::ShaderHandle, uint64_t>;
+
+    // A 64-bit FNV-1a hash of the bytes of a shader, as produced by the shader compiler.
+    inline uint64_t GetShaderKey(gsl::span<const uint8_t> bytes)
+    {
+        return CacheUtils::Fnv1a(bytes.data(), static_cast<size_t>(bytes.size()));
+    }
+}
@@ -1,4 +1,8 @@
 #include "NativeEngine.h"
+#include "ShaderBundle.h"
+#include "ShaderCache.h"
+#include "ShaderCompilationProfiler.h"
+#include "ShaderSourceDump.h"
 #include "ShaderCompiler.h"
 #include <arcana/threading/task.h>
 #include <arcana/threading/task_schedulers.h>
@@ -13,6 +17,12 @@
 
 #include <bx/math.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <regex>
 #include <sstream>
@@ -109,6 +119,21 @@ namespace Babylon
             *image = output;
         }
 
+        // Babylon.js describes vertex buffers one attribute at a time, so each attribute gets its own layout.
+        bgfx::VertexLayout CreateAttributeLayout(uint32_t location, uint32_t byteStride, uint32_t numElements, uint32_t type, bool normalized)
+        {
+            bgfx::VertexLayout vertexLayout{};
+            vertexLayout.begin();
+
+            const bgfx::Attrib::Enum attrib = static_cast<bgfx::Attrib::Enum>(location);
+            const auto attribType = static_cast<bgfx::AttribType::Enum>(type);
+            vertexLayout.add(attrib, static_cast<uint8_t>(numElements), attribType, normalized);
+            vertexLayout.m_stride = static_cast<uint16_t>(byteStride);
+            vertexLayout.end();
+
+            return vertexLayout;
+        }
+
         void CreateTextureFromImage(TextureData* texture, bimg::ImageContainer* image)
         {
             auto releaseFn = [](void* /*ptr*/, void* userData) {
@@ -149,6 +174,9 @@ namespace Babylon
             texture->Width = width;
             texture->Height = height;
         }
+
+        // Applies to every NativeEngine created afterwards, see Babylon::Plugins::NativeEngine::EnableShaderOptimization.
+        std::atomic<bool> s_optimizeShaders{false};
     }
 
     template<typename Handle1T, typename Handle2T>
@@ -169,14 +197,104 @@ namespace Babylon
                 dynamicCallable(std::get<Handle2T>(m_handle));
             }
         }
+
+        // Uniquely identifies the bgfx buffer: the handle's index, tagged with whether the handle is dynamic.
+        uint32_t GetHandleKey() const
+        {
+            const uint32_t idx = std::visit([](auto handle) { return uint32_t{handle.idx}; }, m_handle);
+            return idx | (static_cast<uint32_t>(m_handle.index()) << 16);
+        }
+    };
+
+    class PinnedJsMemoryReleaseQueue;
+
+    // Keeps the memory of a JavaScript typed array alive so that bgfx can reference it in place instead of
+    // copying it. The pin can only be released on the JavaScript thread, whereas bgfx releases the memory it
+    // references on the render thread, so the release goes through a PinnedJsMemoryReleaseQueue.
+    class PinnedJsMemory final
+    {
+    public:
+        PinnedJsMemory(std::shared_ptr<PinnedJsMemoryReleaseQueue> releaseQueue, const Napi::TypedArray& bytes)
+            : m_releaseQueue{std::move(releaseQueue)}
+            , m_reference{Napi::Persistent(bytes)}
+            , m_data{static_cast<uint8_t*>(bytes.ArrayBuffer().Data()) + bytes.ByteOffset()}
+            , m_size{static_cast<uint32_t>(bytes.ByteLength())}
+        {
+        }
+
+        const uint8_t* Data() const
+        {
+            return m_data;
+        }
+
+        uint32_t Size() const
+        {
+            return m_size;
+        }
+
+        // Hands the pin over to bgfx, which releases it once it no longer needs the memory.
+        static const bgfx::Memory* MakeRef(std::unique_ptr<PinnedJsMemory> pin);
+
+    private:
+        std::shared_ptr<PinnedJsMemoryReleaseQueue> m_releaseQueue;
+        Napi::Reference<Napi::TypedArray> m_reference;
+        uint8_t* m_data;
+        uint32_t m_size;
+    };
+
+    // Pins bgfx is done with, waiting to be destroyed on the JavaScript thread. bgfx can release memory
+    // after the JavaScript environment is gone, when it shuts down, so rather than dispatching to the
+    // runtime, the release only ever adds the pin to this queue, which the pins share ownership of.
+    // NativeEngine drains the queue every frame. Pins released after it stopped doing so keep the queue
+    // alive and are leaked along with it, as their references can't be deleted anymore anyway.
+    class PinnedJsMemoryReleaseQueue final
+    {
+    public:
+        // Can be called from any thread.
+        void Push(std::unique_ptr<PinnedJsMemory> pin)
+        {
+            std::scoped_lock lock{m_mutex};
+            m_pins.push_back(std::move(pin));
+        }
+
+        // Must be called from the JavaScript thread.
+        void Drain()
+        {
+            std::vector<std::unique_ptr<PinnedJsMemory>> pins{};
+            {
+                std::scoped_lock lock{m_mutex};
+                pins.swap(m_pins);
+            }
+        }
+
+    private:
+        std::mutex m_mutex{};
+        std::vector<std::unique_ptr<PinnedJsMemory>> m_pins{};
     };
 
+    const bgfx::Memory* PinnedJsMemory::MakeRef(std::unique_ptr<PinnedJsMemory> pin)
+    {
+        PinnedJsMemory* pinPtr = pin.release();
+        return bgfx::makeRef(
+            pinPtr->m_data, pinPtr->m_size, [](void*, void* userData) {
+                std::unique_ptr<PinnedJsMemory> pinnedMemory{static_cast<PinnedJsMemory*>(userData)};
+                auto& releaseQueue = *pinnedMemory->m_releaseQueue;
+                releaseQueue.Push(std::move(pinnedMemory));
+            },
+            pinPtr);
+    }
+
     class IndexBufferData final : private VariantHandleHolder<bgfx::IndexBufferHandle, bgfx::DynamicIndexBufferHandle>
     {
     public:
-        IndexBufferData(const Napi::TypedArray& bytes, uint16_t flags, bool dynamic)
+        using VariantHandleHolder::GetHandleKey;
+
+        // When zeroCopyReleaseQueue is provided, bgfx references the bytes in place (see PinnedJsMemory) rather than copying them.
+        IndexBufferData(const Napi::TypedArray& bytes, uint16_t flags, bool dynamic, const std::shared_ptr<PinnedJsMemoryReleaseQueue>& zeroCopyReleaseQueue)
         {
-            const bgfx::Memory* memory = bgfx::copy(bytes.As<Napi::Uint8Array>().Data(), static_cast<uint32_t>(bytes.ByteLength()));
+            const bgfx::Memory* memory = zeroCopyReleaseQueue != nullptr
+                ? PinnedJsMemory::MakeRef(std::make_unique<PinnedJsMemory>(zeroCopyReleaseQueue, bytes))
+                : bgfx::copy(bytes.As<Napi::Uint8Array>().Data(), static_cast<uint32_t>(bytes.ByteLength()));
             if (!dynamic)
             {
                 m_handle = bgfx::createIndexBuffer(memory, flags);
@@ -226,9 +344,22 @@ namespace Babylon
     class VertexBufferData final : VariantHandleHolder<bgfx::VertexBufferHandle, bgfx::DynamicVertexBufferHandle>
     {
     public:
-        VertexBufferData(const Napi::Uint8Array& bytes, bool dynamic)
-            : m_bytes{bytes.Data(), bytes.Data() + bytes.ByteLength()}
+        using VariantHandleHolder::GetHandleKey;
+
+        // When zeroCopyReleaseQueue is provided, bgfx references the bytes in place (see PinnedJsMemory) rather than copying them.
+        // Dynamic buffers ignore it, as they keep a copy of their bytes around for merging partial updates anyway.
+        // Dynamic buffers register themselves in dynamicBuffers so that their updates can be flushed once per frame.
+        VertexBufferData(const Napi::Uint8Array& bytes, bool dynamic, const std::shared_ptr<PinnedJsMemoryReleaseQueue>& zeroCopyReleaseQueue, arcana::weak_table<VertexBufferData*>& dynamicBuffers)
         {
+            if (zeroCopyReleaseQueue != nullptr && !dynamic)
+            {
+                m_pinnedBytes = std::make_unique<PinnedJsMemory>(zeroCopyReleaseQueue, bytes);
+            }
+            else
+            {
+                m_bytes = {bytes.Data(), bytes.Data() + bytes.ByteLength()};
+            }
+
             if (!dynamic)
             {
                 m_handle = bgfx::VertexBufferHandle{bgfx::kInvalidHandle};
@@ -236,6 +367,7 @@ namespace Babylon
             else
             {
                 m_handle = bgfx::DynamicVertexBufferHandle{bgfx::kInvalidHandle};
+                m_dynamicBuffersTicket.emplace(dynamicBuffers.insert(this));
             }
         }
 
@@ -264,14 +396,7 @@ namespace Babylon
                     return;
                 }
 
-                const bgfx::Memory* memory = bgfx::makeRef(
-                    m_bytes.data(), static_cast<uint32_t>(m_bytes.size()), [](void*, void* userData) {
-                        auto* bytes = reinterpret_cast<std::vector<uint8_t>*>(userData);
-                        bytes->clear();
-                    },
-                    &m_bytes);
-
-                m_handle = bgfx::createVertexBuffer(memory, layout);
+                m_handle = bgfx::createVertexBuffer(MakeInitialMemory(), layout);
             };
             const auto dynamic = [&layout, this](auto handle) {
                 if (handle.idx != bgfx::kInvalidHandle)
@@ -279,39 +404,68 @@ namespace Babylon
                     return;
                 }
 
-                const bgfx::Memory* memory = bgfx::makeRef(
-                    m_bytes.data(), static_cast<uint32_t>(m_bytes.size()), [](void*, void* userData) {
-                        auto* bytes = reinterpret_cast<std::vector<uint8_t>*>(userData);
-                        bytes->clear();
-                    },
-                    &m_bytes);
-
-                m_handle = bgfx::createDynamicVertexBuffer(memory, layout);
+                // Dynamic buffers keep their bytes around for merging partial updates, so bgfx gets a copy.
+                m_handle = bgfx::createDynamicVertexBuffer(bgfx::copy(m_bytes.data(), static_cast<uint32_t>(m_bytes.size())), layout, BGFX_BUFFER_ALLOW_RESIZE);
+                m_stride = layout.m_stride;
             };
             DoForHandleTypes(nonDynamic, dynamic);
         }
 
-        void Update(Napi::Env env, const Napi::Uint8Array& bytes, uint32_t offset, uint32_t byteLength)
+        // Writes byteLength bytes from data at byteOffset in the buffer. Once the buffer has been created, the
+        // updates are merged into a single range which is uploaded to bgfx by the next call to Flush.
+        void Update(Napi::Env env, const uint8_t* data, uint32_t byteOffset, uint32_t byteLength)
         {
             auto nonDynamic = [env](auto) {
                 throw Napi::Error::New(env, "Cannot update non-dynamic vertex buffer.");
             };
-            const auto dynamic = [&bytes, offset, byteLength, this](auto handle) {
-                if (handle.idx == bgfx::kInvalidHandle)
+            const auto dynamic = [data, byteOffset, byteLength, this](auto handle) {
+                const size_t byteEnd = size_t{byteOffset} + byteLength;
+                if (m_bytes.size() < byteEnd)
                 {
-                    // Buffer hasn't been finalized yet, all that's necessary is to swap out the bytes.
-                    m_bytes = {bytes.Data() + offset, bytes.Data() + offset + byteLength};
+                    m_bytes.resize(byteEnd);
                 }
-                else
+                std::memcpy(m_bytes.data() + byteOffset, data, byteLength);
+
+                // Until the buffer is created, it will simply be created from the updated bytes.
+                if (handle.idx != bgfx::kInvalidHandle)
                 {
-                    // Buffer was already created, do a real update operation.
-                    const bgfx::Memory* memory = bgfx::copy(bytes.Data() + offset, byteLength);
-                    bgfx::update(handle, 0, memory);
+                    m_dirtyBegin = std::min(m_dirtyBegin, byteOffset);
+                    m_dirtyEnd = std::max(m_dirtyEnd, static_cast<uint32_t>(byteEnd));
                 }
             };
             DoForHandleTypes(nonDynamic, dynamic);
         }
 
+        // Uploads the range written since the previous flush, if any. Returns the number of bytes uploaded.
+        size_t Flush()
+        {
+            const auto* handle = std::get_if<bgfx::DynamicVertexBufferHandle>(&m_handle);
+            if (handle == nullptr || m_dirtyBegin >= m_dirtyEnd)
+            {
+                return 0;
+            }
+
+            // bgfx updates dynamic vertex buffers a whole number of vertices at a time.
+            const uint32_t byteBegin = m_dirtyBegin / m_stride * m_stride;
+            const uint32_t byteEnd = std::min((m_dirtyEnd + m_stride - 1) / m_stride * m_stride, static_cast<uint32_t>(m_bytes.size()));
+            bgfx::update(*handle, byteBegin / m_stride, bgfx::copy(m_bytes.data() + byteBegin, byteEnd - byteBegin));
+
+            m_dirtyBegin = UINT32_MAX;
+            m_dirtyEnd = 0;
+            return byteEnd - byteBegin;
+        }
+
+        void SetAsBgfxInstanceDataBuffer(uint32_t startInstance, uint32_t numInstances) const
+        {
+            const auto nonDynamic = [startInstance, numInstances](auto handle) {
+                bgfx::setInstanceDataBuffer(handle, startInstance, numInstances);
+            };
+            const auto dynamic = [startInstance, numInstances](auto handle) {
+                bgfx::setInstanceDataBuffer(handle, startInstance, numInstances);
+            };
+            DoForHandleTypes(nonDynamic, dynamic);
+        }
+
         void SetAsBgfxVertexBuffer(uint8_t index, uint32_t startVertex, bgfx::VertexLayoutHandle layout) const
         {
             const auto nonDynamic = [index, startVertex, layout](auto handle) {
@@ -324,7 +478,28 @@ namespace Babylon
         }
 
     private:
+        const bgfx::Memory* MakeInitialMemory()
+        {
+            if (m_pinnedBytes)
+            {
+                return PinnedJsMemory::MakeRef(std::move(m_pinnedBytes));
+            }
+
+            return bgfx::makeRef(
+                m_bytes.data(), static_cast<uint32_t>(m_bytes.size()), [](void*, void* userData) {
+                    auto* bytes = reinterpret_cast<std::vector<uint8_t>*>(userData);
+                    bytes->clear();
+                },
+                &m_bytes);
+        }
+
         std::vector<uint8_t> m_bytes{};
+        std::unique_ptr<PinnedJsMemory> m_pinnedBytes{};
+
+        std::optional<arcana::weak_table<VertexBufferData*>::ticket> m_dynamicBuffersTicket{};
+        uint16_t m_stride{1};
+        uint32_t m_dirtyBegin{UINT32_MAX};
+        uint32_t m_dirtyEnd{0};
     };
 
     void NativeEngine::Initialize(Napi::Env env, bool autoRender)
@@ -350,7 +525,20 @@ namespace Babylon
                 InstanceMethod("deleteVertexBuffer", &NativeEngine::DeleteVertexBuffer),
                 InstanceMethod("recordVertexBuffer", &NativeEngine::RecordVertexBuffer),
                 InstanceMethod("updateDynamicVertexBuffer", &NativeEngine::UpdateDynamicVertexBuffer),
+                InstanceMethod("createTransientGeometry", &NativeEngine::CreateTransientGeometry),
+                InstanceMethod("deleteTransientGeometry", &NativeEngine::DeleteTransientGeometry),
+                InstanceMethod("allocateTransientGeometry", &NativeEngine::AllocateTransientGeometry),
+                InstanceMethod("recordTransientVertexBuffer", &NativeEngine::RecordTransientVertexBuffer),
+                InstanceMethod("drawTransient", &NativeEngine::DrawTransient),
+                InstanceMethod("createInstanceData", &NativeEngine::CreateInstanceData),
+                InstanceMethod("deleteInstanceData", &NativeEngine::DeleteInstanceData),
+                InstanceMethod("allocateInstanceData", &NativeEngine::AllocateInstanceData),
+                InstanceMethod("setInstanceData", &NativeEngine::SetInstanceData),
+                InstanceMethod("setInstanceDataBuffer", &NativeEngine::SetInstanceDataBuffer),
+                InstanceMethod("drawInstanced", &NativeEngine::DrawInstanced),
+                InstanceMethod("multiDrawIndexed", &NativeEngine::MultiDrawIndexed),
                 InstanceMethod("createProgram", &NativeEngine::CreateProgram),
+                InstanceMethod("createProgramAsync", &NativeEngine::CreateProgramAsync),
                 InstanceMethod("getUniforms", &NativeEngine::GetUniforms),
                 InstanceMethod("getAttributes", &NativeEngine::GetAttributes),
                 InstanceMethod("setProgram", &NativeEngine::SetProgram),
@@ -405,6 +593,10 @@ namespace Babylon
                 InstanceMethod("getRenderAPI", &NativeEngine::GetRenderAPI),
                 InstanceMethod("getHardwareScalingLevel", &NativeEngine::GetHardwareScalingLevel),
                 InstanceMethod("setHardwareScalingLevel", &NativeEngine::SetHardwareScalingLevel),
+                InstanceMethod("submitCommands", &NativeEngine::SubmitCommands),
+                InstanceMethod("getFrameStats", &NativeEngine::GetFrameStats),
+                InstanceMethod("getShaderCompilationProfile", &NativeEngine::GetShaderCompilationProfile),
+                InstanceMethod("resetShaderCompilationProfile", &NativeEngine::ResetShaderCompilationProfile),
 
                 InstanceValue("TEXTURE_NEAREST_NEAREST", Napi::Number::From(env, TextureSampling::NEAREST_NEAREST)),
                 InstanceValue("TEXTURE_LINEAR_LINEAR", Napi::Number::From(env, TextureSampling::LINEAR_LINEAR)),
@@ -458,6 +650,35 @@ namespace Babylon
                 InstanceValue("ALPHA_INTERPOLATE", Napi::Number::From(env, AlphaMode::INTERPOLATE)),
                 InstanceValue("ALPHA_SCREENMODE", Napi::Number::From(env, AlphaMode::SCREENMODE)),
 
+                InstanceValue("COMMAND_SETPROGRAM", Napi::Number::From(env, static_cast<uint32_t>(Command::SetProgram))),
+                InstanceValue("COMMAND_SETSTATE", Napi::Number::From(env, static_cast<uint32_t>(Command::SetState))),
+                InstanceValue("COMMAND_SETDEPTHTEST", Napi::Number::From(env, static_cast<uint32_t>(Command::SetDepthTest))),
+                InstanceValue("COMMAND_SETDEPTHWRITE", Napi::Number::From(env, static_cast<uint32_t>(Command::SetDepthWrite))),
+                InstanceValue("COMMAND_SETCOLORWRITE", Napi::Number::From(env, static_cast<uint32_t>(Command::SetColorWrite))),
+                InstanceValue("COMMAND_SETBLENDMODE", Napi::Number::From(env, static_cast<uint32_t>(Command::SetBlendMode))),
+                InstanceValue("COMMAND_SETINT", Napi::Number::From(env, static_cast<uint32_t>(Command::SetInt))),
+                InstanceValue("COMMAND_SETINTARRAY", Napi::Number::From(env, static_cast<uint32_t>(Command::SetIntArray))),
+                InstanceValue("COMMAND_SETINTARRAY2", Napi::Number::From(env, static_cast<uint32_t>(Command::SetIntArray2))),
+                InstanceValue("COMMAND_SETINTARRAY3", Napi::Number::From(env, static_cast<uint32_t>(Command::SetIntArray3))),
+                InstanceValue("COMMAND_SETINTARRAY4", Napi::Number::From(env, static_cast<uint32_t>(Command::SetIntArray4))),
+                InstanceValue("COMMAND_SETFLOAT", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloat))),
+                InstanceValue("COMMAND_SETFLOAT2", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloat2))),
+                InstanceValue("COMMAND_SETFLOAT3", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloat3))),
+                InstanceValue("COMMAND_SETFLOAT4", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloat4))),
+                InstanceValue("COMMAND_SETFLOATARRAY", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloatArray))),
+                InstanceValue("COMMAND_SETFLOATARRAY2", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloatArray2))),
+                InstanceValue("COMMAND_SETFLOATARRAY3", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloatArray3))),
+                InstanceValue("COMMAND_SETFLOATARRAY4", Napi::Number::From(env, static_cast<uint32_t>(Command::SetFloatArray4))),
+                InstanceValue("COMMAND_SETMATRIX", Napi::Number::From(env, static_cast<uint32_t>(Command::SetMatrix))),
+                InstanceValue("COMMAND_SETMATRIX3X3", Napi::Number::From(env, static_cast<uint32_t>(Command::SetMatrix3x3))),
+                InstanceValue("COMMAND_SETMATRIX2X2", Napi::Number::From(env, static_cast<uint32_t>(Command::SetMatrix2x2))),
+                InstanceValue("COMMAND_SETMATRICES", Napi::Number::From(env, static_cast<uint32_t>(Command::SetMatrices))),
+                InstanceValue("COMMAND_SETTEXTURE", Napi::Number::From(env, static_cast<uint32_t>(Command::SetTexture))),
+                InstanceValue("COMMAND_BINDVERTEXARRAY", Napi::Number::From(env, static_cast<uint32_t>(Command::BindVertexArray))),
+                InstanceValue("COMMAND_DRAWINDEXED", Napi::Number::From(env, static_cast<uint32_t>(Command::DrawIndexed))),
+                InstanceValue("COMMAND_DRAW", Napi::Number::From(env, static_cast<uint32_t>(Command::Draw))),
+                InstanceValue("COMMAND_MULTIDRAWINDEXED", Napi::Number::From(env, static_cast<uint32_t>(Command::MultiDrawIndexed))),
+
                 InstanceValue(JS_AUTO_RENDER_PROPERTY_NAME, Napi::Boolean::New(env, autoRender))});
 
         JsRuntime::NativeObject::GetFromJavaScript(env).Set(JS_ENGINE_CONSTRUCTOR_NAME, func);
@@ -477,9 +698,14 @@ namespace Babylon
         : Napi::ObjectWrap<NativeEngine>{info}
         , AutomaticRenderingEnabled{info.This().As<Napi::Object>().Get(JS_AUTO_RENDER_PROPERTY_NAME).ToBoolean()}
         , RuntimeScheduler{runtime}
+        , FrameRuntimeScheduler{runtime, JsRuntime::DispatchPriority::FrameCritical}
+        , m_shaderCompiler{std::make_shared<ShaderCompiler>(ShaderCompiler::Options{s_optimizeShaders})}
         , m_runtime{runtime}
+        , m_backgroundRuntimeScheduler{runtime, JsRuntime::DispatchPriority::Background}
         , m_graphicsImpl{Graphics::Impl::GetFromJavaScript(info.Env())}
         , m_engineState{BGFX_STATE_DEFAULT}
+        , m_pinnedMemoryReleaseQueue{std::make_shared<PinnedJsMemoryReleaseQueue>()}
+        , m_frameBufferManager{info.Env()}
     {
     }
 
@@ -488,12 +714,30 @@ namespace Babylon
         Dispose();
     }
 
+    void NativeEngine::EnableShaderOptimization(bool enabled)
+    {
+        if (enabled && !ShaderCompiler::IsSpirvOptimizerAvailable())
+        {
+            throw std::runtime_error{"Shader optimization requires glslang to be built with ENABLE_OPT and SPIRV-Tools."};
+        }
+
+        s_optimizeShaders = enabled;
+    }
+
     template<typename SchedulerT>
     arcana::task<void, std::exception_ptr> NativeEngine::GetRequestAnimationFrameTask(SchedulerT& scheduler)
     {
         return arcana::make_task(scheduler, m_cancelSource, [this] {
             m_isRenderScheduled = false;
 
+            ++m_frameId;
+            m_pinnedMemoryReleaseQueue->Drain();
+            m_previousFrameStats = m_frameStats;
+            m_frameStats = {};
+            InvalidateBgfxState();
+            m_currentInstanceData = nullptr;
+            m_currentInstanceBuffer = nullptr;
+
             if (!m_requestAnimationFrameCallback.IsEmpty())
             {
                 // We can get here from either the normal RequestAnimationFrame or the XR RequestAnimationFrame,
@@ -503,7 +747,14 @@ namespace Babylon
                 callback({});
             }
 
+            // Upload everything written to dynamic vertex buffers this frame, at most once per buffer.
+            m_dynamicVertexBuffers.apply_to_all([this](auto vertexBufferData) {
+                m_frameStats.DynamicVertexBytesUploaded += vertexBufferData->Flush();
+            });
+
             GetFrameBufferManager().Reset();
+            m_frameStats.ViewsUsed = m_frameBufferManager.GetViewsUsed();
+            m_frameStats.ViewsRecycled = m_frameBufferManager.GetViewsRecycled();
         });
     }
 
@@ -520,14 +771,14 @@ namespace Babylon
                 }
                 else
                 {
-                    m_graphicsImpl.AddRenderWorkTask(GetRequestAnimationFrameTask(RuntimeScheduler));
+                    m_graphicsImpl.AddRenderWorkTask(GetRequestAnimationFrameTask(FrameRuntimeScheduler));
                 }
             });
             if (AutomaticRenderingEnabled)
             {
                 Dispatch([this] {
                     m_graphicsImpl.RenderCurrentFrame();
-                });
+                }, JsRuntime::DispatchPriority::FrameCritical);
             }
         }
     }
@@ -537,12 +788,21 @@ namespace Babylon
         return m_frameBufferManager;
     }
 
+    void NativeEngine::InvalidateBgfxState()
+    {
+        m_shadowState.Invalidate();
+        m_lastSubmittedProgram = nullptr;
+    }
+
     void NativeEngine::Dispose()
     {
         m_cancelSource.cancel();
+        m_pinnedMemoryReleaseQueue->Drain();
 
-        // This collection contains bgfx data, so it must be cleared before bgfx::shutdown is called.
+        // These collections contain bgfx data, so they must be cleared before bgfx::shutdown is called.
         m_programDataCollection.clear();
+        m_shaderHandleCache.Clear();
+        m_vertexLayoutCache.Clear();
     }
 
     void NativeEngine::Dispose(const Napi::CallbackInfo& /*info*/)
@@ -576,26 +836,60 @@ namespace Babylon
 
     Napi::Value NativeEngine::CreateVertexArray(const Napi::CallbackInfo& info)
     {
-        return Napi::External<VertexArray>::New(info.Env(), new VertexArray{});
+        auto* vertexArray = new VertexArray{m_vertexLayoutCache};
+        m_commandObjects.Add(vertexArray);
+        return Napi::External<VertexArray>::New(info.Env(), vertexArray);
     }
 
     void NativeEngine::DeleteVertexArray(const Napi::CallbackInfo& info)
     {
-        delete info[0].As<Napi::External<VertexArray>>().Data();
+        auto* vertexArray = info[0].As<Napi::External<VertexArray>>().Data();
+        m_commandObjects.Remove(vertexArray);
+        delete vertexArray;
     }
 
     void NativeEngine::BindVertexArray(const Napi::CallbackInfo& info)
     {
-        const auto& vertexArray = *(info[0].As<Napi::External<VertexArray>>().Data());
+        BindVertexArrayInternal(*(info[0].As<Napi::External<VertexArray>>().Data()));
+    }
 
+    void NativeEngine::BindVertexArrayInternal(const VertexArray& vertexArray)
+    {
         // a vertex array might not have an index buffer associated with
         m_currentBoundIndexBuffer = vertexArray.indexBuffer.data;
 
+        uint32_t streamMask{0};
         const auto& vertexBuffers = vertexArray.vertexBuffers;
         for (auto vertexBufferPair : vertexBuffers)
         {
+            assert(vertexBufferPair.first < ShadowState::MaxVertexStreams);
+            const auto stream = static_cast<uint8_t>(vertexBufferPair.first);
             const auto& vertexBuffer = vertexBufferPair.second;
-            vertexBuffer.data->SetAsBgfxVertexBuffer(static_cast<uint8_t>(vertexBufferPair.first), vertexBuffer.startVertex, vertexBuffer.vertexLayoutHandle);
+            streamMask |= 1u << stream;
+
+            if (m_shadowState.SetVertexStream(stream, vertexBuffer.data->GetHandleKey(), vertexBuffer.startVertex, vertexBuffer.vertexLayoutHandle.idx))
+            {
+                vertexBuffer.data->SetAsBgfxVertexBuffer(stream, vertexBuffer.startVertex, vertexBuffer.vertexLayoutHandle);
+            }
+            else
+            {
+                ++m_frameStats.RedundantVertexBufferSetsSkipped;
+            }
+        }
+
+        UnbindVertexStreamsExcept(streamMask);
+    }
+
+    void NativeEngine::UnbindVertexStreamsExcept(uint32_t streamMask)
+    {
+        // Streams are kept across draws, so unbind the ones left over from previous draws.
+        uint32_t staleStreams = m_shadowState.ReleaseVertexStreams(streamMask);
+        for (uint8_t stream = 0; staleStreams != 0; ++stream, staleStreams >>= 1)
+        {
+            if ((staleStreams & 1) != 0)
+            {
+                bgfx::setVertexBuffer(stream, bgfx::VertexBufferHandle{bgfx::kInvalidHandle});
+            }
         }
     }
 
@@ -604,9 +898,11 @@ namespace Babylon
         const Napi::TypedArray data = info[0].As<Napi::TypedArray>();
         const bool dynamic = info[1].As<Napi::Boolean>().Value();
 
+        const bool zeroCopy = info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
+
         const uint16_t flags = data.TypedArrayType() == napi_typedarray_type::napi_uint16_array ? 0 : BGFX_BUFFER_INDEX32;
 
-        return Napi::External<IndexBufferData>::New(info.Env(), new IndexBufferData(data, flags, dynamic));
+        return Napi::External<IndexBufferData>::New(info.Env(), new IndexBufferData(data, flags, dynamic, zeroCopy ? m_pinnedMemoryReleaseQueue : nullptr));
     }
 
     void NativeEngine::DeleteIndexBuffer(const Napi::CallbackInfo& info)
@@ -637,13 +933,18 @@ namespace Babylon
     {
         const Napi::Uint8Array data = info[0].As<Napi::Uint8Array>();
         const bool dynamic = info[1].As<Napi::Boolean>().Value();
+        const bool zeroCopy = info[2].IsBoolean() && info[2].As<Napi::Boolean>().Value();
 
-        return Napi::External<VertexBufferData>::New(info.Env(), new VertexBufferData(data, dynamic));
+        return Napi::External<VertexBufferData>::New(info.Env(), new VertexBufferData(data, dynamic, zeroCopy ? m_pinnedMemoryReleaseQueue : nullptr, m_dynamicVertexBuffers));
     }
 
     void NativeEngine::DeleteVertexBuffer(const Napi::CallbackInfo& info)
     {
         auto* vertexBufferData = info[0].As<Napi::External<VertexBufferData>>().Data();
+        if (m_currentInstanceBuffer == vertexBufferData)
+        {
+            m_currentInstanceBuffer = nullptr;
+        }
         delete vertexBufferData;
     }
 
@@ -659,18 +960,11 @@ namespace Babylon
         const uint32_t type = info[6].As<Napi::Number>().Uint32Value();
         const bool normalized = info[7].As<Napi::Boolean>().Value();
 
-        bgfx::VertexLayout vertexLayout{};
-        vertexLayout.begin();
-
-        const bgfx::Attrib::Enum attrib = static_cast<bgfx::Attrib::Enum>(location);
-        const auto attribType = static_cast<bgfx::AttribType::Enum>(type);
-        vertexLayout.add(attrib, static_cast<uint8_t>(numElements), attribType, normalized);
-        vertexLayout.m_stride = static_cast<uint16_t>(byteStride);
-        vertexLayout.end();
+        const bgfx::VertexLayout vertexLayout = CreateAttributeLayout(location, byteStride, numElements, type, normalized);
 
         vertexBufferData->EnsureFinalized(info.Env(), vertexLayout);
 
-        vertexArray.vertexBuffers[location] = {vertexBufferData, byteOffset / byteStride, bgfx::createVertexLayout(vertexLayout)};
+        vertexArray.RecordVertexBuffer(location, vertexBufferData, byteOffset / byteStride, vertexLayout);
     }
 
     void NativeEngine::UpdateDynamicVertexBuffer(const Napi::CallbackInfo& info)
@@ -678,34 +972,381 @@ namespace Babylon
         VertexBufferData& vertexBufferData = *(info[0].As<Napi::External<VertexBufferData>>().Data());
         const Napi::Uint8Array data = info[1].As<Napi::Uint8Array>();
         const uint32_t byteOffset = info[2].As<Napi::Number>().Uint32Value();
+        const uint32_t byteLength = info[3].As<Napi::Number>().Uint32Value();
 
-        uint32_t byteLength = info[2].As<Napi::Number>().Uint32Value();
         if (byteLength == 0)
         {
-            byteLength = static_cast<uint32_t>(data.ByteLength());
+            // The whole of data is written at byteOffset.
+            vertexBufferData.Update(info.Env(), data.Data(), byteOffset, static_cast<uint32_t>(data.ByteLength()));
+        }
+        else
+        {
+            // data mirrors the whole buffer, of which the byteLength bytes at byteOffset are written.
+            if (size_t{byteOffset} + byteLength > data.ByteLength())
+            {
+                throw Napi::Error::New(info.Env(), "Dynamic vertex buffer update range is out of bounds.");
+            }
+            vertexBufferData.Update(info.Env(), data.Data() + byteOffset, byteOffset, byteLength);
         }
+    }
+
+    Napi::Value NativeEngine::CreateTransientGeometry(const Napi::CallbackInfo& info)
+    {
+        return Napi::External<TransientGeometry>::New(info.Env(), new TransientGeometry{m_vertexLayoutCache});
+    }
 
-        vertexBufferData.Update(info.Env(), data, byteOffset, byteLength);
+    void NativeEngine::DeleteTransientGeometry(const Napi::CallbackInfo& info)
+    {
+        delete info[0].As<Napi::External<TransientGeometry>>().Data();
+    }
+
+    Napi::Value NativeEngine::AllocateTransientGeometry(const Napi::CallbackInfo& info)
+    {
+        TransientGeometry& geometry = *(info[0].As<Napi::External<TransientGeometry>>().Data());
+        const uint32_t vertexCount = info[1].As<Napi::Number>().Uint32Value();
+        const uint32_t byteStride = info[2].As<Napi::Number>().Uint32Value();
+        const uint32_t indexCount = info[3].As<Napi::Number>().Uint32Value();
+
+        if (byteStride == 0 || byteStride > UINT16_MAX)
+        {
+            throw Napi::Error::New(info.Env(), "Invalid transient vertex stride.");
+        }
+
+        // The attributes are described by the layouts recorded for them, the allocation only needs the stride.
+        bgfx::VertexLayout vertexLayout{};
+        vertexLayout.begin();
+        vertexLayout.m_stride = static_cast<uint16_t>(byteStride);
+        vertexLayout.end();
+
+        if (bgfx::getAvailTransientVertexBuffer(vertexCount, vertexLayout) < vertexCount ||
+            bgfx::getAvailTransientIndexBuffer(indexCount) < indexCount)
+        {
+            throw Napi::Error::New(info.Env(), "Not enough transient buffer space left in this frame.");
+        }
+
+        bgfx::allocTransientVertexBuffer(&geometry.vertexBuffer, vertexCount, vertexLayout);
+        if (indexCount > 0)
+        {
+            bgfx::allocTransientIndexBuffer(&geometry.indexBuffer, indexCount);
+        }
+        geometry.indexCount = indexCount;
+        geometry.frameId = m_frameId;
+        geometry.uploaded = false;
+
+        const size_t indexBytes = size_t{indexCount} * sizeof(uint16_t);
+        m_frameStats.TransientBytesAllocated += geometry.vertexBuffer.size + indexBytes;
+
+        // bgfx's memory is never exposed to JavaScript, which could otherwise keep writing into it once the
+        // renderer owns it. Geometry allocated with the same sizes as in the previous frame reuses its buffers.
+        if (geometry.vertexData.IsEmpty() || geometry.vertexData.Value().ByteLength() != geometry.vertexBuffer.size)
+        {
+            geometry.vertexData = Napi::Persistent(Napi::ArrayBuffer::New(info.Env(), geometry.vertexBuffer.size));
+        }
+        if (geometry.indexData.IsEmpty() || geometry.indexData.Value().ByteLength() != indexBytes)
+        {
+            geometry.indexData = Napi::Persistent(Napi::ArrayBuffer::New(info.Env(), indexBytes));
+        }
+
+        auto result = Napi::Object::New(info.Env());
+        result.Set("vertices", geometry.vertexData.Value());
+        result.Set("indices", Napi::Uint16Array::New(info.Env(), indexCount, geometry.indexData.Value(), 0));
+        return std::move(result);
+    }
+
+    void NativeEngine::RecordTransientVertexBuffer(const Napi::CallbackInfo& info)
+    {
+        TransientGeometry& geometry = *(info[0].As<Napi::External<TransientGeometry>>().Data());
+        const uint32_t location = info[1].As<Napi::Number>().Uint32Value();
+        const uint32_t byteOffset = info[2].As<Napi::Number>().Uint32Value();
+        const uint32_t byteStride = info[3].As<Napi::Number>().Uint32Value();
+        const uint32_t numElements = info[4].As<Napi::Number>().Uint32Value();
+        const uint32_t type = info[5].As<Napi::Number>().Uint32Value();
+        const bool normalized = info[6].As<Napi::Boolean>().Value();
+
+        geometry.RecordAttribute(location, byteOffset / byteStride, CreateAttributeLayout(location, byteStride, numElements, type, normalized));
+    }
+
+    void NativeEngine::DrawTransient(const Napi::CallbackInfo& info)
+    {
+        TransientGeometry& geometry = *(info[0].As<Napi::External<TransientGeometry>>().Data());
+        const auto fillMode = info[1].As<Napi::Number>().Int32Value();
+        const auto elementStart = info[2].As<Napi::Number>().Uint32Value();
+        const auto elementCount = info[3].As<Napi::Number>().Uint32Value();
+
+        if (geometry.frameId != m_frameId)
+        {
+            throw Napi::Error::New(info.Env(), "Transient geometry can only be drawn during the frame it was allocated in.");
+        }
+
+        geometry.Upload(info.Env());
+
+        // Without indices, the element range is a range of vertices.
+        const bool indexed = geometry.indexCount > 0;
+
+        // Transient buffers change every frame, so their bindings aren't tracked and are always set.
+        uint32_t streamMask{0};
+        for (const auto& attributePair : geometry.attributes)
+        {
+            assert(attributePair.first < ShadowState::MaxVertexStreams);
+            const auto stream = static_cast<uint8_t>(attributePair.first);
+            const auto& attribute = attributePair.second;
+            streamMask |= 1u << stream;
+
+            if (indexed)
+            {
+                bgfx::setVertexBuffer(stream, &geometry.vertexBuffer, attribute.startVertex, UINT32_MAX, attribute.vertexLayoutHandle);
+            }
+            else
+            {
+                bgfx::setVertexBuffer(stream, &geometry.vertexBuffer, attribute.startVertex + elementStart, elementCount, attribute.vertexLayoutHandle);
+            }
+            m_shadowState.SetVertexStreamUntracked(stream);
+        }
+
+        UnbindVertexStreamsExcept(streamMask);
+
+        if (indexed)
+        {
+            bgfx::setIndexBuffer(&geometry.indexBuffer, elementStart, elementCount);
+            m_shadowState.SetIndexBufferUntracked();
+        }
+        else if (m_shadowState.ClearIndexBuffer())
+        {
+            bgfx::discard(BGFX_DISCARD_INDEX_BUFFER);
+        }
+
+        // As with Draw, the vertex array must be bound again before the next indexed draw.
+        m_currentBoundIndexBuffer = nullptr;
+
+        SubmitInternal(fillMode);
+    }
+
+    Napi::Value NativeEngine::CreateInstanceData(const Napi::CallbackInfo& info)
+    {
+        return Napi::External<InstanceData>::New(info.Env(), new InstanceData{});
+    }
+
+    void NativeEngine::DeleteInstanceData(const Napi::CallbackInfo& info)
+    {
+        const InstanceData* instanceData = info[0].As<Napi::External<InstanceData>>().Data();
+        if (m_currentInstanceData == instanceData)
+        {
+            m_currentInstanceData = nullptr;
+        }
+        delete instanceData;
+    }
+
+    Napi::Value NativeEngine::AllocateInstanceData(const Napi::CallbackInfo& info)
+    {
+        InstanceData& instanceData = *(info[0].As<Napi::External<InstanceData>>().Data());
+        const uint32_t instanceCount = info[1].As<Napi::Number>().Uint32Value();
+        const uint32_t byteStride = info[2].As<Napi::Number>().Uint32Value();
+
+        // bgfx passes instance data to shaders as whole vec4s.
+        if (byteStride == 0 || byteStride % 16 != 0 || byteStride > UINT16_MAX)
+        {
+            throw Napi::Error::New(info.Env(), "Instance data stride must be a non-zero multiple of 16 bytes.");
+        }
+
+        if (bgfx::getAvailInstanceDataBuffer(instanceCount, static_cast<uint16_t>(byteStride)) < instanceCount)
+        {
+            throw Napi::Error::New(info.Env(), "Not enough instance data buffer space left in this frame.");
+        }
+
+        bgfx::allocInstanceDataBuffer(&instanceData.buffer, instanceCount, static_cast<uint16_t>(byteStride));
+        instanceData.frameId = m_frameId;
+        instanceData.uploaded = false;
+
+        m_frameStats.TransientBytesAllocated += instanceData.buffer.size;
+
+        // As for transient geometry, bgfx's memory is never exposed to JavaScript.
+        if (instanceData.data.IsEmpty() || instanceData.data.Value().ByteLength() != instanceData.buffer.size)
+        {
+            instanceData.data = Napi::Persistent(Napi::ArrayBuffer::New(info.Env(), instanceData.buffer.size));
+        }
+        return instanceData.data.Value();
+    }
+
+    void NativeEngine::SetInstanceData(const Napi::CallbackInfo& info)
+    {
+        InstanceData* instanceData = info[0].As<Napi::External<InstanceData>>().Data();
+        if (instanceData->frameId != m_frameId)
+        {
+            throw Napi::Error::New(info.Env(), "Instance data can only be used during the frame it was allocated in.");
+        }
+
+        m_currentInstanceData = instanceData;
+        m_currentInstanceBuffer = nullptr;
+    }
+
+    void NativeEngine::SetInstanceDataBuffer(const Napi::CallbackInfo& info)
+    {
+        VertexBufferData* vertexBufferData = info[0].As<Napi::External<VertexBufferData>>().Data();
+        const uint32_t byteStride = info[1].As<Napi::Number>().Uint32Value();
+        const uint32_t startInstance = info[2].As<Napi::Number>().Uint32Value();
+        const uint32_t instanceCount = info[3].As<Napi::Number>().Uint32Value();
+
+        if (byteStride == 0 || byteStride % 16 != 0 || byteStride > UINT16_MAX)
+        {
+            throw Napi::Error::New(info.Env(), "Instance data stride must be a non-zero multiple of 16 bytes.");
+        }
+
+        // bgfx reads the instance stride from the buffer's layout, the attributes themselves are never used.
+        bgfx::VertexLayout vertexLayout{};
+        vertexLayout.begin();
+        vertexLayout.m_stride = static_cast<uint16_t>(byteStride);
+        vertexLayout.end();
+
+        vertexBufferData->EnsureFinalized(info.Env(), vertexLayout);
+
+        m_currentInstanceData = nullptr;
+        m_currentInstanceBuffer = vertexBufferData;
+        m_currentInstanceStart = startInstance;
+        m_currentInstanceCount = instanceCount;
+    }
+
+    void NativeEngine::DrawInstanced(const Napi::CallbackInfo& info)
+    {
+        const auto fillMode = info[0].As<Napi::Number>().Int32Value();
+        const auto elementStart = info[1].As<Napi::Number>().Int32Value();
+        const auto elementCount = info[2].As<Napi::Number>().Int32Value();
+
+        if (m_currentInstanceData != nullptr)
+        {
+            m_currentInstanceData->Upload(info.Env());
+            bgfx::setInstanceDataBuffer(&m_currentInstanceData->buffer);
+            m_frameStats.InstancesDrawn += m_currentInstanceData->buffer.num;
+        }
+        else if (m_currentInstanceBuffer != nullptr)
+        {
+            m_currentInstanceBuffer->SetAsBgfxInstanceDataBuffer(m_currentInstanceStart, m_currentInstanceCount);
+            m_frameStats.InstancesDrawn += m_currentInstanceCount;
+        }
+        else
+        {
+            throw Napi::Error::New(info.Env(), "No instance data set for instanced draw.");
+        }
+
+        DrawIndexedInternal(fillMode, elementStart, elementCount);
     }
 
     Napi::Value NativeEngine::CreateProgram(const Napi::CallbackInfo& info)
     {
         const std::string vertexSource{info[0].As<Napi::String>().Utf8Value()};
         const std::string fragmentSource{info[1].As<Napi::String>().Utf8Value()};
+        ShaderSourceDump::Write(vertexSource, fragmentSource);
 
-        std::unique_ptr<ProgramData> programData{std::make_unique<ProgramData>()};
         ShaderCompiler::BgfxShaderInfo shaderInfo{};
 
         try
         {
-            shaderInfo = m_shaderCompiler.Compile(vertexSource, fragmentSource);
+            shaderInfo = CompileShaders(*m_shaderCompiler, m_graphicsImpl.GetCacheDirectory(), vertexSource, fragmentSource);
         }
         catch (const std::exception& ex)
         {
             throw Napi::Error::New(info.Env(), ex.what());
         }
 
-        static auto InitUniformInfos{[](bgfx::ShaderHandle shader, const std::unordered_map<std::string, uint8_t>& uniformStages, std::unordered_map<std::string, UniformInfo>& uniformInfos) {
+        return CreateProgramInternal(info.Env(), shaderInfo);
+    }
+
+    void NativeEngine::CreateProgramAsync(const Napi::CallbackInfo& info)
+    {
+        std::string vertexSource{info[0].As<Napi::String>().Utf8Value()};
+        std::string fragmentSource{info[1].As<Napi::String>().Utf8Value()};
+        const auto onSuccess = info[2].As<Napi::Function>();
+        const auto onError = info[3].As<Napi::Function>();
+        ShaderSourceDump::Write(vertexSource, fragmentSource);
+
+        // GLSL sources never contain null characters, which makes for an unambiguous separator.
+        std::string key{vertexSource};
+        key.push_back('\0');
+        key.append(fragmentSource);
+
+        auto [pending, inserted] = m_pendingPrograms.try_emplace(std::move(key));
+        pending->second.push_back({Napi::Persistent(onSuccess), Napi::Persistent(onError)});
+        if (!inserted)
+        {
+            return;
+        }
+
+        // The engine can be disposed while the compilation runs, which only cancels the continuation, so the
+        // compilation owns everything it uses.
+        arcana::make_task(arcana::threadpool_scheduler, m_cancelSource,
+            [compiler{m_shaderCompiler}, cacheDirectory{m_graphicsImpl.GetCacheDirectory()}, vertexSource{std::move(vertexSource)}, fragmentSource{std::move(fragmentSource)}]() {
+                return CompileShaders(*compiler, cacheDirectory, vertexSource, fragmentSource);
+            })
+            .then(RuntimeScheduler, m_cancelSource, [this, env = info.Env(), key = pending->first](arcana::expected<ShaderCompiler::BgfxShaderInfo, std::exception_ptr> result) {
+                auto callbacks = m_pendingPrograms.extract(key);
+
+                Napi::HandleScope scope{env};
+                if (result.has_error())
+                {
+                    std::string message{"Unable to compile program."};
+                    try
+                    {
+                        std::rethrow_exception(result.error());
+                    }
+                    catch (const std::exception& ex)
+                    {
+                        message = ex.what();
+                    }
+                    catch (...)
+                    {
+                    }
+
+                    for (const auto& callback : callbacks.mapped())
+                    {
+                        callback.OnError.Call({Napi::String::New(env, message)});
+                    }
+                }
+                else
+                {
+                    // Each request gets its own program data since it holds the program's uniform values, but
+                    // bgfx shares the underlying shaders and program between them.
+                    for (const auto& callback : callbacks.mapped())
+                    {
+                        callback.OnSuccess.Call({CreateProgramInternal(env, result.value())});
+                    }
+                }
+            });
+    }
+
+    ShaderCompiler::BgfxShaderInfo NativeEngine::CompileShaders(ShaderCompiler& compiler, const std::string& cacheDirectory, std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        const uint64_t key{ShaderCache::ComputeKey(vertexSource, fragmentSource, compiler.GetOptions())};
+        if (auto shaderInfo{ShaderBundle::FindMounted(key)})
+        {
+            return std::move(*shaderInfo);
+        }
+
+        const auto compile = [&compiler, vertexSource, fragmentSource, key]() {
+            ShaderCompiler::Statistics statistics{};
+            ShaderCompiler::BgfxShaderInfo shaderInfo{compiler.Compile(vertexSource, fragmentSource, statistics)};
+            ShaderCompilationProfiler::Record(vertexSource, key, statistics);
+            return shaderInfo;
+        };
+
+        if (cacheDirectory.empty())
+        {
+            return compile();
+        }
+
+        if (auto shaderInfo{ShaderCache::Read(cacheDirectory, key)})
+        {
+            return std::move(*shaderInfo);
+        }
+
+        ShaderCompiler::BgfxShaderInfo shaderInfo{compile()};
+        ShaderCache::Write(cacheDirectory, key, shaderInfo);
+        return shaderInfo;
+    }
+
+    Napi::Value NativeEngine::CreateProgramInternal(Napi::Env env, const ShaderCompiler::BgfxShaderInfo& shaderInfo)
+    {
+        std::unique_ptr<ProgramData> programData{std::make_unique<ProgramData>(m_shaderHandleCache, m_commandObjects)};
+
+        static auto InitUniformInfos{[](ProgramData& programData, bgfx::ShaderHandle shader, const std::unordered_map<std::string, uint8_t>& uniformStages, std::unordered_map<std::string, UniformInfo>& uniformInfos) {
             auto numUniforms = bgfx::getShaderUniforms(shader);
             std::vector<bgfx::UniformHandle> uniforms{numUniforms};
             bgfx::getShaderUniforms(shader, uniforms.data(), gsl::narrow_cast<uint16_t>(uniforms.size()));
@@ -722,21 +1363,52 @@ namespace Babylon
                     YFlip = (!strcmp(info.name, "projection")) || (!strcmp(info.name, "viewProjection"));
                 }
                 uniformInfos[info.name].YFlip = YFlip;
+
+                if (info.type != bgfx::UniformType::Sampler)
+                {
+                    uniformInfos[info.name].Slot = programData.AddUniformSlot(uniforms[index], info, YFlip);
+                }
             }
         }};
 
-        auto vertexShader = bgfx::createShader(bgfx::copy(shaderInfo.VertexBytes.data(), static_cast<uint32_t>(shaderInfo.VertexBytes.size())));
-        InitUniformInfos(vertexShader, shaderInfo.VertexUniformStages, programData->VertexUniformInfos);
-        programData->VertexAttributeLocations = std::move(shaderInfo.VertexAttributeLocations);
+        // Programs sharing a stage share its shader, so the program must not destroy its shaders itself.
+        const auto acquireShader = [this](const std::vector<uint8_t>& bytes) {
+            return m_shaderHandleCache.Acquire(GetShaderKey(bytes), [&bytes] {
+                return bgfx::createShader(bgfx::copy(bytes.data(), static_cast<uint32_t>(bytes.size())));
+            });
+        };
+
+        const auto vertexShader = programData->VertexShader = acquireShader(shaderInfo.VertexBytes);
+        InitUniformInfos(*programData, vertexShader, shaderInfo.VertexUniformStages, programData->VertexUniformInfos);
+        programData->VertexAttributeLocations = shaderInfo.VertexAttributeLocations;
 
-        auto fragmentShader = bgfx::createShader(bgfx::copy(shaderInfo.FragmentBytes.data(), static_cast<uint32_t>(shaderInfo.FragmentBytes.size())));
-        InitUniformInfos(fragmentShader, shaderInfo.FragmentUniformStages, programData->FragmentUniformInfos);
+        const auto fragmentShader = programData->FragmentShader = acquireShader(shaderInfo.FragmentBytes);
+        InitUniformInfos(*programData, fragmentShader, shaderInfo.FragmentUniformStages, programData->FragmentUniformInfos);
 
-        programData->Program = bgfx::createProgram(vertexShader, fragmentShader, true);
+        // Uniforms packed together by the shader compiler are still set by their original names, so each of
+        // them gets an info pointing into the slot of the vec4 it was packed into.
+        for (const auto& [name, packedUniform] : shaderInfo.PackedUniforms)
+        {
+            for (auto* uniformInfos : {&programData->VertexUniformInfos, &programData->FragmentUniformInfos})
+            {
+                const auto it = uniformInfos->find(packedUniform.Name);
+                if (it != uniformInfos->end())
+                {
+                    UniformInfo uniformInfo{it->second};
+                    uniformInfo.PackedComponent = packedUniform.Component;
+                    uniformInfo.PackedComponents = packedUniform.Components;
+                    (*uniformInfos)[name] = uniformInfo;
+                    break;
+                }
+            }
+        }
+
+        programData->Program = bgfx::createProgram(vertexShader, fragmentShader, false);
+        programData->RegisterCommandObjects();
         auto* rawProgramData = programData.get();
         auto ticket = m_programDataCollection.insert(std::move(programData));
         auto finalizer = [ticket = std::move(ticket)](Napi::Env, ProgramData*) {};
-        return Napi::External<ProgramData>::New(info.Env(), rawProgramData, std::move(finalizer));
+        return Napi::External<ProgramData>::New(env, rawProgramData, std::move(finalizer));
     }
 
     Napi::Value NativeEngine::GetUniforms(const Napi::CallbackInfo& info)
@@ -792,7 +1464,11 @@ namespace Babylon
 
     void NativeEngine::SetProgram(const Napi::CallbackInfo& info)
     {
-        auto program = info[0].As<Napi::External<ProgramData>>().Data();
+        SetProgramInternal(info[0].As<Napi::External<ProgramData>>().Data());
+    }
+
+    void NativeEngine::SetProgramInternal(ProgramData* program)
+    {
         m_currentProgram = program;
     }
 
@@ -802,6 +1478,14 @@ namespace Babylon
         const auto cullBackFaces = info[2].As<Napi::Boolean>().Value();
         const auto reverseSide = info[3].As<Napi::Boolean>().Value();
 
+        // TODO: zOffset
+        //const auto zOffset = info[1].As<Napi::Number>().FloatValue();
+
+        SetStateInternal(culling, cullBackFaces, reverseSide);
+    }
+
+    void NativeEngine::SetStateInternal(bool culling, bool cullBackFaces, bool reverseSide)
+    {
         m_engineState &= ~(BGFX_STATE_CULL_MASK | BGFX_STATE_FRONT_CCW);
         m_engineState |= reverseSide ? 0 : BGFX_STATE_FRONT_CCW;
 
@@ -809,8 +1493,6 @@ namespace Babylon
         {
             m_engineState |= cullBackFaces ? BGFX_STATE_CULL_CCW : BGFX_STATE_CULL_CW;
         }
-        // TODO: zOffset
-        //const auto zOffset = info[1].As<Napi::Number>().FloatValue();
     }
 
     void NativeEngine::SetZOffset(const Napi::CallbackInfo& /*info*/)
@@ -828,8 +1510,11 @@ namespace Babylon
 
     void NativeEngine::SetDepthTest(const Napi::CallbackInfo& info)
     {
-        const auto depthTest = info[0].As<Napi::Number>().Uint32Value();
+        SetDepthTestInternal(info[0].As<Napi::Number>().Uint32Value());
+    }
 
+    void NativeEngine::SetDepthTestInternal(uint32_t depthTest)
+    {
         m_engineState &= ~BGFX_STATE_DEPTH_TEST_MASK;
         m_engineState |= depthTest;
     }
@@ -841,24 +1526,33 @@ namespace Babylon
 
     void NativeEngine::SetDepthWrite(const Napi::CallbackInfo& info)
     {
-        const auto enable = info[0].As<Napi::Boolean>().Value();
+        SetDepthWriteInternal(info[0].As<Napi::Boolean>().Value());
+    }
 
+    void NativeEngine::SetDepthWriteInternal(bool enable)
+    {
         m_engineState &= ~BGFX_STATE_WRITE_Z;
         m_engineState |= enable ? BGFX_STATE_WRITE_Z : 0;
     }
 
     void NativeEngine::SetColorWrite(const Napi::CallbackInfo& info)
     {
-        const auto enable = info[0].As<Napi::Boolean>().Value();
+        SetColorWriteInternal(info[0].As<Napi::Boolean>().Value());
+    }
 
+    void NativeEngine::SetColorWriteInternal(bool enable)
+    {
         m_engineState &= ~(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
         m_engineState |= enable ? (BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A) : 0;
     }
 
     void NativeEngine::SetBlendMode(const Napi::CallbackInfo& info)
     {
-        const auto blendMode = info[0].As<Napi::Number>().Int64Value();
+        SetBlendModeInternal(static_cast<uint64_t>(info[0].As<Napi::Number>().Int64Value()));
+    }
 
+    void NativeEngine::SetBlendModeInternal(uint64_t blendMode)
+    {
         m_engineState &= ~BGFX_STATE_BLEND_MASK;
         m_engineState |= blendMode;
     }
@@ -867,7 +1561,7 @@ namespace Babylon
     {
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto value = info[1].As<Napi::Number>().FloatValue();
-        m_currentProgram->SetUniform(uniformInfo->Handle, gsl::make_span(&value, 1), uniformInfo->YFlip);
+        SetUniformFloatN<1>(*uniformInfo, &value);
     }
 
     template<int size, typename arrayType>
@@ -876,7 +1570,13 @@ namespace Babylon
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto array = info[1].As<arrayType>();
 
-        size_t elementLength = array.ElementLength();
+        SetUniformArrayN<size>(*uniformInfo, gsl::make_span(array.Data(), array.ElementLength()));
+    }
+
+    template<int size, typename ElementT>
+    void NativeEngine::SetUniformArrayN(const UniformInfo& uniformInfo, gsl::span<const ElementT> array)
+    {
+        const size_t elementLength = static_cast<size_t>(array.size());
 
         m_scratch.clear();
         for (size_t index = 0; index < elementLength; index += size)
@@ -890,7 +1590,7 @@ namespace Babylon
             m_scratch.insert(m_scratch.end(), values, values + 4);
         }
 
-        m_currentProgram->SetUniform(uniformInfo->Handle, m_scratch, uniformInfo->YFlip, elementLength / size);
+        m_currentProgram->SetUniform(uniformInfo, m_scratch, elementLength / size);
     }
 
     template<int size>
@@ -904,7 +1604,20 @@ namespace Babylon
             (size > 3) ? info[4].As<Napi::Number>().FloatValue() : 0.f,
         };
 
-        m_currentProgram->SetUniform(uniformInfo->Handle, values, uniformInfo->YFlip);
+        SetUniformFloatN<size>(*uniformInfo, values);
+    }
+
+    template<int size>
+    void NativeEngine::SetUniformFloatN(const UniformInfo& uniformInfo, const float* values)
+    {
+        const float paddedValues[] = {
+            values[0],
+            (size > 1) ? values[1] : 0.f,
+            (size > 2) ? values[2] : 0.f,
+            (size > 3) ? values[3] : 0.f,
+        };
+
+        m_currentProgram->SetUniform(uniformInfo, paddedValues);
     }
 
     template<int size>
@@ -917,6 +1630,12 @@ namespace Babylon
         assert(elementLength == size * size);
         (void)elementLength;
 
+        SetUniformMatrixN<size>(*uniformInfo, matrix.Data());
+    }
+
+    template<int size>
+    void NativeEngine::SetUniformMatrixN(const UniformInfo& uniformInfo, const float* matrix)
+    {
         if constexpr (size < 4)
         {
             std::array<float, 16> matrixValues{};
@@ -930,11 +1649,11 @@ namespace Babylon
                 }
             }
 
-            m_currentProgram->SetUniform(uniformInfo->Handle, gsl::make_span(matrixValues.data(), 16), uniformInfo->YFlip);
+            m_currentProgram->SetUniform(uniformInfo, gsl::make_span(matrixValues.data(), 16));
         }
         else
         {
-            m_currentProgram->SetUniform(uniformInfo->Handle, gsl::make_span(matrix.Data(), elementLength), uniformInfo->YFlip);
+            m_currentProgram->SetUniform(uniformInfo, gsl::make_span(matrix, 16));
         }
     }
 
@@ -982,11 +1701,23 @@ namespace Babylon
     {
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto matricesArray = info[1].As<Napi::Float32Array>();
+        if (matricesArray.ElementLength() % 16 != 0)
+        {
+            throw Napi::Error::New(info.Env(), "Matrices must be made of 16 floats each.");
+        }
+
+        SetUniformMatrices(*uniformInfo, gsl::make_span(matricesArray.Data(), matricesArray.ElementLength()));
+    }
 
-        const size_t elementLength = matricesArray.ElementLength();
-        assert(elementLength % 16 == 0);
+    void NativeEngine::SetUniformMatrices(const UniformInfo& uniformInfo, gsl::span<const float> matrices)
+    {
+        const size_t elementLength = static_cast<size_t>(matrices.size());
+        if (elementLength % 16 != 0)
+        {
+            throw std::runtime_error{"Matrices must be made of 16 floats each."};
+        }
 
-        m_currentProgram->SetUniform(uniformInfo->Handle, gsl::span(matricesArray.Data(), elementLength), uniformInfo->YFlip, elementLength / 16);
+        m_currentProgram->SetUniform(uniformInfo, matrices, elementLength / 16);
     }
 
     void NativeEngine::SetMatrix2x2(const Napi::CallbackInfo& info)
@@ -1026,7 +1757,9 @@ namespace Babylon
 
     Napi::Value NativeEngine::CreateTexture(const Napi::CallbackInfo& info)
     {
-        return Napi::External<TextureData>::New(info.Env(), new TextureData());
+        auto* texture = new TextureData();
+        m_commandObjects.Add(texture);
+        return Napi::External<TextureData>::New(info.Env(), texture);
     }
 
     void NativeEngine::LoadTexture(const Napi::CallbackInfo& info)
@@ -1067,13 +1800,13 @@ namespace Babylon
                 }
                 return image;
             })
-            .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, dataRef{Napi::Persistent(data)}](bimg::ImageContainer* image) {
+            .then(m_backgroundRuntimeScheduler, arcana::cancellation::none(), [this, texture, dataRef{Napi::Persistent(data)}](bimg::ImageContainer* image) {
                 ScheduleRender();
                 return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [texture, image] {
                     CreateTextureFromImage(texture, image);
                 });
             })
-            .then(RuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
+            .then(m_backgroundRuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
                 if (result.has_error())
                 {
                     onErrorRef.Call({});
@@ -1139,13 +1872,13 @@ namespace Babylon
         }
 
         arcana::when_all(gsl::make_span(tasks))
-            .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, generateMips, dataRefs{std::move(dataRefs)}](std::vector<bimg::ImageContainer*> images) {
+            .then(m_backgroundRuntimeScheduler, arcana::cancellation::none(), [this, texture, generateMips, dataRefs{std::move(dataRefs)}](std::vector<bimg::ImageContainer*> images) {
                 ScheduleRender();
                 return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [texture, generateMips, images = std::move(images)] {
                     CreateCubeTextureFromImages(texture, images, generateMips);
                 });
             })
-            .then(RuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
+            .then(m_backgroundRuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
                 if (result.has_error())
                 {
                     onErrorRef.Call({});
@@ -1185,13 +1918,13 @@ namespace Babylon
         }
 
         arcana::when_all(gsl::make_span(tasks))
-            .then(RuntimeScheduler, arcana::cancellation::none(), [this, texture, dataRefs{std::move(dataRefs)}](std::vector<bimg::ImageContainer*> images) {
+            .then(m_backgroundRuntimeScheduler, arcana::cancellation::none(), [this, texture, dataRefs{std::move(dataRefs)}](std::vector<bimg::ImageContainer*> images) {
                 ScheduleRender();
                 return m_graphicsImpl.GetAfterRenderTask().then(arcana::inline_scheduler, m_cancelSource, [texture, images = std::move(images)] {
                     CreateCubeTextureFromImages(texture, images, true);
                 });
             })
-            .then(RuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
+            .then(m_backgroundRuntimeScheduler, m_cancelSource, [onSuccessRef{Napi::Persistent(onSuccess)}, onErrorRef{Napi::Persistent(onError)}](arcana::expected<void, std::exception_ptr> result) {
                 if (result.has_error())
                 {
                     onErrorRef.Call({});
@@ -1267,12 +2000,25 @@ namespace Babylon
         const auto uniformInfo = info[0].As<Napi::External<UniformInfo>>().Data();
         const auto texture = info[1].As<Napi::External<TextureData>>().Data();
 
-        bgfx::setTexture(uniformInfo->Stage, uniformInfo->Handle, texture->Handle, texture->Flags);
+        SetTextureInternal(*uniformInfo, *texture);
+    }
+
+    void NativeEngine::SetTextureInternal(const UniformInfo& uniformInfo, const TextureData& texture)
+    {
+        if (m_shadowState.SetTexture(uniformInfo.Stage, uniformInfo.Handle.idx, texture.Handle.idx, texture.Flags))
+        {
+            bgfx::setTexture(uniformInfo.Stage, uniformInfo.Handle, texture.Handle, texture.Flags);
+        }
+        else
+        {
+            ++m_frameStats.RedundantTextureSetsSkipped;
+        }
     }
 
     void NativeEngine::DeleteTexture(const Napi::CallbackInfo& info)
     {
         const auto texture = info[0].As<Napi::External<TextureData>>().Data();
+        m_commandObjects.Remove(texture);
         delete texture;
     }
 
@@ -1351,13 +2097,64 @@ namespace Babylon
         const auto fillMode = info[0].As<Napi::Number>().Int32Value();
         const auto elementStart = info[1].As<Napi::Number>().Int32Value();
         const auto elementCount = info[2].As<Napi::Number>().Int32Value();
+
+        DrawIndexedInternal(fillMode, elementStart, elementCount);
+    }
+
+    void NativeEngine::DrawIndexedInternal(int32_t fillMode, int32_t elementStart, int32_t elementCount)
+    {
         // TODO: handle viewport
 
         if (m_currentBoundIndexBuffer)
         {
-            m_currentBoundIndexBuffer->SetBgfxIndexBuffer(elementStart, elementCount);
+            if (m_shadowState.SetIndexBuffer(m_currentBoundIndexBuffer->GetHandleKey(), elementStart, elementCount))
+            {
+                m_currentBoundIndexBuffer->SetBgfxIndexBuffer(elementStart, elementCount);
+            }
+            else
+            {
+                ++m_frameStats.RedundantIndexBufferSetsSkipped;
+            }
+        }
+
+        SubmitInternal(fillMode);
+    }
+
+    void NativeEngine::MultiDrawIndexed(const Napi::CallbackInfo& info)
+    {
+        const auto fillMode = info[0].As<Napi::Number>().Int32Value();
+        if (!info[1].IsTypedArray() || info[1].As<Napi::TypedArray>().TypedArrayType() != napi_int32_array)
+        {
+            throw Napi::TypeError::New(info.Env(), "Multi-draw arguments must be an Int32Array.");
         }
 
+        const auto draws = info[1].As<Napi::Int32Array>();
+        if (draws.ElementLength() % 2 != 0)
+        {
+            throw Napi::Error::New(info.Env(), "Multi-draw arguments must be pairs of element start and element count.");
+        }
+
+        MultiDrawIndexedInternal(fillMode, gsl::make_span(draws.Data(), draws.ElementLength()));
+    }
+
+    void NativeEngine::MultiDrawIndexedInternal(int32_t fillMode, gsl::span<const int32_t> draws)
+    {
+        const size_t drawsLength = static_cast<size_t>(draws.size());
+        if (drawsLength % 2 != 0)
+        {
+            throw std::runtime_error{"Multi-draw arguments must be pairs of element start and element count."};
+        }
+
+        // The draws share everything but their range of elements, so after the first one only the index
+        // buffer range actually reaches bgfx; the rest is skipped as redundant.
+        for (size_t index = 0; index < drawsLength; index += 2)
+        {
+            DrawIndexedInternal(fillMode, draws[index], draws[index + 1]);
+        }
+    }
+
+    void NativeEngine::SubmitInternal(int32_t fillMode)
+    {
         // TODO: support other fill modes
         uint64_t fillModeState = 0; //indexed tri list
         switch (fillMode)
@@ -1376,74 +2173,82 @@ namespace Babylon
                 break;
         }
 
-        if (m_frameBufferManager.IsRenderingToTarget() && (!bgfx::getCaps()->originBottomLeft))
-        {
-            // UV coordinates system are different between OpenGL and Direct3D/Metal
-            // This is not an issue with loaded textures (png/jpg...) because
-            // texel rows bytes are also using a different convention
-            // see https://www.puredevsoftware.com/blog/2018/03/17/texture-coordinates-d3d-vs-opengl/
-            // for render to texture, as the texel bytes are not reversed, sampling a RTT for
-            // post process or shadows will result in inversion on V axis (Y)
-            // to compensate for that, any matrix that is used to project onto clip-space has
-            // to be flipped.
-            // The involved matrices are determined by name and a boolean YFlip is set to true.
-            // When rendering to texture, those matrices are flipped and set as uniform datas.
-            // But because flipping clip-space coordinates also flips triangles winding,
-            // Culling also has to be flipped.
-            for (const auto& it : m_currentProgram->Uniforms)
-            {
-                const ProgramData::UniformValue& value = it.second;
-                if (value.YFlip)
-                {
-                    float tmpMatrix[16];
-                    static const float flipMatrix[16] = {1.f, 0.f, 0.f, 0.f,
-                        0.f, -1.f, 0.f, 0.f,
-                        0.f, 0.f, 1.f, 0.f,
-                        0.f, 0.f, 0.f, 1.f};
-                    bx::mtxMul(tmpMatrix, value.Data.data(), flipMatrix);
-                    bgfx::setUniform({it.first}, tmpMatrix, value.ElementLength);
-                }
-                else
-                {
-                    bgfx::setUniform({it.first}, value.Data.data(), value.ElementLength);
-                }
-            }
+        // UV coordinates system are different between OpenGL and Direct3D/Metal
+        // This is not an issue with loaded textures (png/jpg...) because
+        // texel rows bytes are also using a different convention
+        // see https://www.puredevsoftware.com/blog/2018/03/17/texture-coordinates-d3d-vs-opengl/
+        // for render to texture, as the texel bytes are not reversed, sampling a RTT for
+        // post process or shadows will result in inversion on V axis (Y)
+        // to compensate for that, any matrix that is used to project onto clip-space has
+        // to be flipped.
+        // The involved matrices are determined by name and a boolean YFlip is set to true.
+        // When rendering to texture, those matrices are flipped and set as uniform datas.
+        // But because flipping clip-space coordinates also flips triangles winding,
+        // Culling also has to be flipped.
+        const bool yFlip = m_frameBufferManager.IsRenderingToTarget() && (!bgfx::getCaps()->originBottomLeft);
+        FrameBufferData& frameBufferData{m_frameBufferManager.GetBound()};
+        frameBufferData.IsViewUsed = true;
+        const bgfx::ViewId viewId = frameBufferData.ViewId;
 
+        const bool uploadAllUniforms = m_currentProgram != m_lastSubmittedProgram || viewId != m_lastSubmittedViewId || yFlip != m_lastSubmittedYFlip;
+        m_frameStats.UniformBytesUploaded += m_currentProgram->UploadUniforms(uploadAllUniforms, yFlip);
+
+        uint64_t state = m_engineState | fillModeState;
+        if (yFlip)
+        {
             // We need to explicitly swap the culling state flags (instead of XOR)
             // because we would like to preserve the no culling configuration, which is 00.
             const auto cullCW = (m_engineState & BGFX_STATE_CULL_CCW) != 0 ? BGFX_STATE_CULL_CW : 0;
             const auto cullCCW = (m_engineState & BGFX_STATE_CULL_CW) != 0 ? BGFX_STATE_CULL_CCW : 0;
 
-            uint64_t m_engineStateYFlipped = m_engineState;
-            m_engineStateYFlipped &= ~BGFX_STATE_CULL_MASK;
-            m_engineStateYFlipped |= (cullCW | cullCCW) << BGFX_STATE_CULL_SHIFT;
+            state &= ~BGFX_STATE_CULL_MASK;
+            state |= (cullCW | cullCCW) << BGFX_STATE_CULL_SHIFT;
+        }
 
-            bgfx::setState(m_engineStateYFlipped | fillModeState);
+        if (m_shadowState.SetState(state))
+        {
+            bgfx::setState(state);
         }
         else
         {
-            for (const auto& it : m_currentProgram->Uniforms)
-            {
-                const ProgramData::UniformValue& value = it.second;
-                bgfx::setUniform({it.first}, value.Data.data(), value.ElementLength);
-            }
-            bgfx::setState(m_engineState | fillModeState);
+            ++m_frameStats.RedundantStateSetsSkipped;
         }
 
-        bgfx::submit(m_frameBufferManager.GetBound().ViewId, m_currentProgram->Program, 0, BGFX_DISCARD_INSTANCE_DATA | BGFX_DISCARD_STATE | BGFX_DISCARD_TRANSFORM);
+        // Keep the state, bindings, vertex streams and index buffer for the next draw, as tracked by m_shadowState.
+        bgfx::submit(viewId, m_currentProgram->Program, 0, BGFX_DISCARD_INSTANCE_DATA | BGFX_DISCARD_TRANSFORM);
+
+        m_lastSubmittedProgram = m_currentProgram;
+        m_lastSubmittedViewId = viewId;
+        m_lastSubmittedYFlip = yFlip;
     }
 
     void NativeEngine::Draw(const Napi::CallbackInfo& info)
     {
-        bgfx::discard(BGFX_DISCARD_INDEX_BUFFER);
+        const auto fillMode = info[0].As<Napi::Number>().Int32Value();
+        const auto verticesStart = info[1].As<Napi::Number>().Int32Value();
+        const auto verticesCount = info[2].As<Napi::Number>().Int32Value();
+
+        DrawInternal(fillMode, verticesStart, verticesCount);
+    }
+
+    void NativeEngine::DrawInternal(int32_t fillMode, int32_t verticesStart, int32_t verticesCount)
+    {
+        if (m_shadowState.ClearIndexBuffer())
+        {
+            bgfx::discard(BGFX_DISCARD_INDEX_BUFFER);
+        }
+        else
+        {
+            ++m_frameStats.RedundantIndexBufferSetsSkipped;
+        }
         m_currentBoundIndexBuffer = nullptr;
-        DrawIndexed(info);
+        DrawIndexedInternal(fillMode, verticesStart, verticesCount);
     }
 
     void NativeEngine::Clear(const Napi::CallbackInfo& info)
     {
-        FrameBufferData& frameBufferData{m_frameBufferManager.GetBound()};
-        frameBufferData.UseViewId(m_frameBufferManager.GetNewViewId());
+        FrameBufferData& frameBufferData{m_frameBufferManager.UseNewViewForBound()};
+        frameBufferData.IsViewUsed = true;
 
         ViewClearState& viewClearState{frameBufferData.ViewClearState};
         uint16_t flags{0};
@@ -1478,6 +2283,9 @@ namespace Babylon
         }
 
         viewClearState.UpdateFlags(flags);
+
+        // Updating the clear state discards everything set on bgfx so far.
+        InvalidateBgfxState();
     }
 
     Napi::Value NativeEngine::GetRenderWidth(const Napi::CallbackInfo& info)
@@ -1515,13 +2323,6 @@ namespace Babylon
         return Napi::Value::From(info.Env(), static_cast<int>(bgfx::getRendererType()));
     }
 
-    void NativeEngine::Dispatch(std::function<void()> function)
-    {
-        m_runtime.Dispatch([function = std::move(function)](Napi::Env) {
-            function();
-        });
-    }
-
     void NativeEngine::SetHardwareScalingLevel(const Napi::CallbackInfo& info)
     {
         const auto level = info[0].As<Napi::Number>().FloatValue();
@@ -1532,4 +2333,267 @@ namespace Babylon
     {
         return Napi::Value::From(info.Env(), m_graphicsImpl.GetHardwareScalingLevel());
     }
+
+    Napi::Value NativeEngine::GetFrameStats(const Napi::CallbackInfo& info)
+    {
+        // Report the last complete frame, the current one is still being recorded.
+        auto stats = Napi::Object::New(info.Env());
+        stats.Set("uniformBytesUploaded", Napi::Value::From(info.Env(), static_cast<double>(m_previousFrameStats.UniformBytesUploaded)));
+        stats.Set("dynamicVertexBytesUploaded", Napi::Value::From(info.Env(), static_cast<double>(m_previousFrameStats.DynamicVertexBytesUploaded)));
+        stats.Set("transientBytesAllocated", Napi::Value::From(info.Env(), static_cast<double>(m_previousFrameStats.TransientBytesAllocated)));
+        stats.Set("instancesDrawn", Napi::Value::From(info.Env(), m_previousFrameStats.InstancesDrawn));
+        stats.Set("viewsUsed", Napi::Value::From(info.Env(), m_previousFrameStats.ViewsUsed));
+        stats.Set("viewsRecycled", Napi::Value::From(info.Env(), m_previousFrameStats.ViewsRecycled));
+        stats.Set("redundantStateSetsSkipped", Napi::Value::From(info.Env(), m_previousFrameStats.RedundantStateSetsSkipped));
+        stats.Set("redundantVertexBufferSetsSkipped", Napi::Value::From(info.Env(), m_previousFrameStats.RedundantVertexBufferSetsSkipped));
+        stats.Set("redundantIndexBufferSetsSkipped", Napi::Value::From(info.Env(), m_previousFrameStats.RedundantIndexBufferSetsSkipped));
+        stats.Set("redundantTextureSetsSkipped", Napi::Value::From(info.Env(), m_previousFrameStats.RedundantTextureSetsSkipped));
+        return std::move(stats);
+    }
+
+    Napi::Value NativeEngine::GetShaderCompilationProfile(const Napi::CallbackInfo& info)
+    {
+        const auto env = info.Env();
+        const auto profile = ShaderCompilationProfiler::Get();
+
+        // Durations are reported in milliseconds, like performance.now.
+        const auto toMilliseconds = [env](std::chrono::nanoseconds duration) {
+            return Napi::Value::From(env, std::chrono::duration<double, std::milli>{duration}.count());
+        };
+
+        auto stages = Napi::Array::New(env, profile.Stages.size());
+        for (uint32_t index = 0; index < profile.Stages.size(); ++index)
+        {
+            const auto& stage = profile.Stages[index];
+            auto stageObject = Napi::Object::New(env);
+            stageObject.Set("name", Napi::String::New(env, stage.Name));
+            stageObject.Set("count", Napi::Value::From(env, stage.Count));
+            stageObject.Set("totalMilliseconds", toMilliseconds(stage.TotalDuration));
+            stageObject.Set("maxMilliseconds", toMilliseconds(stage.MaxDuration));
+            stages[index] = stageObject;
+        }
+
+        auto slowestShaders = Napi::Array::New(env, profile.SlowestShaders.size());
+        for (uint32_t index = 0; index < profile.SlowestShaders.size(); ++index)
+        {
+            const auto& shader = profile.SlowestShaders[index];
+            auto stageMilliseconds = Napi::Object::New(env);
+            for (size_t stageIndex = 0; stageIndex < shader.StageDurations.size(); ++stageIndex)
+            {
+                stageMilliseconds.Set(profile.Stages[stageIndex].Name, toMilliseconds(shader.StageDurations[stageIndex]));
+            }
+
+            // Keys don't fit in a JavaScript number, so they are reported as hexadecimal strings.
+            char key[17]{};
+            std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(shader.Key));
+
+            auto shaderObject = Napi::Object::New(env);
+            shaderObject.Set("name", Napi::String::New(env, shader.Name));
+            shaderObject.Set("key", Napi::String::New(env, key));
+            shaderObject.Set("milliseconds", toMilliseconds(shader.Duration));
+            shaderObject.Set("stages", stageMilliseconds);
+            slowestShaders[index] = shaderObject;
+        }
+
+        auto profileObject = Napi::Object::New(env);
+        profileObject.Set("compilations", Napi::Value::From(env, profile.Compilations));
+        profileObject.Set("totalMilliseconds", toMilliseconds(profile.TotalDuration));
+        profileObject.Set("stages", stages);
+        profileObject.Set("slowestShaders", slowestShaders);
+        return std::move(profileObject);
+    }
+
+    void NativeEngine::ResetShaderCompilationProfile(const Napi::CallbackInfo&)
+    {
+        ShaderCompilationProfiler::Reset();
+    }
+
+    void NativeEngine::SubmitCommands(const Napi::CallbackInfo& info)
+    {
+        CommandBufferReader reader{info[0], info[1], m_commandObjects};
+
+        try
+        {
+            while (reader.HasMore())
+            {
+                const auto command = reader.ReadUint32();
+                if (command >= static_cast<uint32_t>(Command::Count))
+                {
+                    throw std::runtime_error{"Unknown command " + std::to_string(command) + " at word " + std::to_string(reader.Position() - 1) + "."};
+                }
+
+                ExecuteCommand(static_cast<Command>(command), reader);
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            throw Napi::Error::New(info.Env(), ex.what());
+        }
+    }
+
+    void NativeEngine::ExecuteCommand(Command command, CommandBufferReader& reader)
+    {
+        switch (command)
+        {
+            case Command::SetProgram:
+            {
+                SetProgramInternal(&reader.ReadObject<ProgramData>());
+                break;
+            }
+            case Command::SetState:
+            {
+                const auto culling = reader.ReadBoolean();
+                reader.ReadFloat32(); // TODO: zOffset
+                const auto cullBackFaces = reader.ReadBoolean();
+                const auto reverseSide = reader.ReadBoolean();
+                SetStateInternal(culling, cullBackFaces, reverseSide);
+                break;
+            }
+            case Command::SetDepthTest:
+            {
+                SetDepthTestInternal(reader.ReadUint32());
+                break;
+            }
+            case Command::SetDepthWrite:
+            {
+                SetDepthWriteInternal(reader.ReadBoolean());
+                break;
+            }
+            case Command::SetColorWrite:
+            {
+                SetColorWriteInternal(reader.ReadBoolean());
+                break;
+            }
+            case Command::SetBlendMode:
+            {
+                SetBlendModeInternal(reader.ReadUint64());
+                break;
+            }
+            case Command::SetInt:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                const auto value = static_cast<float>(reader.ReadInt32());
+                SetUniformFloatN<1>(uniformInfo, &value);
+                break;
+            }
+            case Command::SetIntArray:
+            case Command::SetIntArray2:
+            case Command::SetIntArray3:
+            case Command::SetIntArray4:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                const auto values = reader.ReadSpan<int32_t>(reader.ReadUint32());
+                switch (command)
+                {
+                    case Command::SetIntArray: SetUniformArrayN<1>(uniformInfo, values); break;
+                    case Command::SetIntArray2: SetUniformArrayN<2>(uniformInfo, values); break;
+                    case Command::SetIntArray3: SetUniformArrayN<3>(uniformInfo, values); break;
+                    default: SetUniformArrayN<4>(uniformInfo, values); break;
+                }
+                break;
+            }
+            case Command::SetFloat:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformFloatN<1>(uniformInfo, reader.ReadSpan<float>(1).data());
+                break;
+            }
+            case Command::SetFloat2:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformFloatN<2>(uniformInfo, reader.ReadSpan<float>(2).data());
+                break;
+            }
+            case Command::SetFloat3:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformFloatN<3>(uniformInfo, reader.ReadSpan<float>(3).data());
+                break;
+            }
+            case Command::SetFloat4:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformFloatN<4>(uniformInfo, reader.ReadSpan<float>(4).data());
+                break;
+            }
+            case Command::SetFloatArray:
+            case Command::SetFloatArray2:
+            case Command::SetFloatArray3:
+            case Command::SetFloatArray4:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                const auto values = reader.ReadSpan<float>(reader.ReadUint32());
+                switch (command)
+                {
+                    case Command::SetFloatArray: SetUniformArrayN<1>(uniformInfo, values); break;
+                    case Command::SetFloatArray2: SetUniformArrayN<2>(uniformInfo, values); break;
+                    case Command::SetFloatArray3: SetUniformArrayN<3>(uniformInfo, values); break;
+                    default: SetUniformArrayN<4>(uniformInfo, values); break;
+                }
+                break;
+            }
+            case Command::SetMatrix:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformMatrixN<4>(uniformInfo, reader.ReadSpan<float>(16).data());
+                break;
+            }
+            case Command::SetMatrix3x3:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformMatrixN<3>(uniformInfo, reader.ReadSpan<float>(9).data());
+                break;
+            }
+            case Command::SetMatrix2x2:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformMatrixN<2>(uniformInfo, reader.ReadSpan<float>(4).data());
+                break;
+            }
+            case Command::SetMatrices:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                SetUniformMatrices(uniformInfo, reader.ReadSpan<float>(reader.ReadUint32()));
+                break;
+            }
+            case Command::SetTexture:
+            {
+                const auto& uniformInfo = reader.ReadObject<UniformInfo>();
+                const auto& texture = reader.ReadObject<TextureData>();
+                SetTextureInternal(uniformInfo, texture);
+                break;
+            }
+            case Command::BindVertexArray:
+            {
+                BindVertexArrayInternal(reader.ReadObject<VertexArray>());
+                break;
+            }
+            case Command::DrawIndexed:
+            {
+                const auto fillMode = reader.ReadInt32();
+                const auto elementStart = reader.ReadInt32();
+                const auto elementCount = reader.ReadInt32();
+                DrawIndexedInternal(fillMode, elementStart, elementCount);
+                break;
+            }
+            case Command::Draw:
+            {
+                const auto fillMode = reader.ReadInt32();
+                const auto verticesStart = reader.ReadInt32();
+                const auto verticesCount = reader.ReadInt32();
+                DrawInternal(fillMode, verticesStart, verticesCount);
+                break;
+            }
+            case Command::MultiDrawIndexed:
+            {
+                const auto fillMode = reader.ReadInt32();
+                MultiDrawIndexedInternal(fillMode, reader.ReadSpan<int32_t>(reader.ReadUint32()));
+                break;
+            }
+            default:
+            {
+                throw std::runtime_error{"Unhandled command."};
+            }
+        }
+    }
 }
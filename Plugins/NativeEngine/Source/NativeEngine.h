@@ -2,6 +2,9 @@
 
 #include "ShaderCompiler.h"
 #include "BgfxCallback.h"
+#include "CommandBuffer.h"
+#include "HandleCache.h"
+#include "ShadowState.h"
 
 #include <Babylon/JsRuntime.h>
 #include <Babylon/JsRuntimeScheduler.h>
@@ -14,6 +17,7 @@
 #include <bgfx/platform.h>
 #include <bimg/bimg.h>
 #include <bx/allocator.h>
+#include <bx/simd_t.h>
 
 #include <gsl/gsl>
 
@@ -21,7 +25,11 @@
 
 #include <arcana/containers/weak_table.h>
 #include <arcana/threading/cancellation.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 namespace Babylon
 {
@@ -207,10 +215,18 @@ namespace Babylon
             if (IsViewIdDirty || viewId != ViewId)
             {
                 ViewId = viewId;
+                // Draws must execute in submission order, as they do in WebGL. By default, bgfx sorts the
+                // draws of a view by blending and then by program, which reorders the transparent meshes
+                // Babylon.js sorts back to front whenever they use different materials. NativeEngine also
+                // relies on this order to only upload the uniforms which changed since the previous draw,
+                // which bgfx would otherwise apply on top of the values of another draw. Every view draws
+                // Babylon.js meshes, so every view needs it.
+                bgfx::setViewMode(ViewId, bgfx::ViewMode::Sequential);
                 bgfx::setViewFrameBuffer(ViewId, FrameBuffer);
                 SetViewPort(0, 0, 1, 1); // Default to full viewport
                 ViewClearState.UpdateViewId(ViewId);
                 IsViewIdDirty = false;
+                IsViewUsed = false;
             }
         }
 
@@ -228,6 +244,9 @@ namespace Babylon
         bgfx::FrameBufferHandle FrameBuffer{bgfx::kInvalidHandle};
         bgfx::ViewId ViewId{uint16_t(~0)};
         bool IsViewIdDirty{true};
+        // Whether anything, including a clear, was submitted to the view since it was assigned. Views which
+        // are still unused when their frame buffer moves on are given back to the FrameBufferManager.
+        bool IsViewUsed{false};
         Babylon::ViewClearState ViewClearState;
         uint16_t Width{};
         uint16_t Height{};
@@ -246,7 +265,9 @@ namespace Babylon
 
     struct FrameBufferManager final
     {
-        FrameBufferManager()
+        // Views are handed out from calls made by JavaScript, so running out of them raises an error in env.
+        explicit FrameBufferManager(Napi::Env env)
+            : m_env{env}
         {
             Bind(m_defaultBackBuffer = new FrameBufferData(BGFX_INVALID_HANDLE, m_activeFrameBuffers, GetNewViewId(), 0, 0, true, true));
         }
@@ -263,6 +284,11 @@ namespace Babylon
 
         void Bind(FrameBufferData* data)
         {
+            if (data != m_boundFrameBuffer)
+            {
+                RecycleBoundViewIfUnused();
+            }
+
             m_boundFrameBuffer = data;
 
             const auto fbViewId = m_boundFrameBuffer->IsViewIdDirty ? GetNewViewId() : m_boundFrameBuffer->ViewId;
@@ -296,31 +322,114 @@ namespace Babylon
             }
         }
 
+        // Views are executed in the order they were first handed out during the frame, whatever their ids.
         uint16_t GetNewViewId()
         {
-            m_nextId++;
-            assert(m_nextId < bgfx::getCaps()->limits.maxViews);
-            return m_nextId;
+            bgfx::ViewId viewId;
+            if (!m_freeViewIds.empty())
+            {
+                viewId = m_freeViewIds.back();
+                m_freeViewIds.pop_back();
+            }
+            else if (m_viewIdCount < bgfx::getCaps()->limits.maxViews)
+            {
+                viewId = m_viewIdCount++;
+            }
+            else
+            {
+                throw Napi::Error::New(m_env, "Ran out of bgfx views for this frame.");
+            }
+
+            m_viewOrder.push_back(viewId);
+            return viewId;
+        }
+
+        // Gives the bound frame buffer a new view, as required to clear it. Its current view is reused if
+        // nothing was submitted to it yet.
+        FrameBufferData& UseNewViewForBound()
+        {
+            FrameBufferData& frameBufferData{GetBound()};
+            RecycleBoundViewIfUnused();
+            frameBufferData.UseViewId(GetNewViewId());
+            return frameBufferData;
         }
 
+        // Must be called once the frame is fully submitted and before it is rendered, as it applies the
+        // order in which its views must be executed.
         void Reset()
         {
-            m_nextId = 0;
+            m_viewsUsed = static_cast<uint32_t>(m_viewOrder.size());
+            m_viewsRecycled = m_viewsRecycledInFrame;
+            m_viewsRecycledInFrame = 0;
+
+            // The order must be a permutation of all the views handed out so far, the unused ones go last.
+            m_viewOrder.insert(m_viewOrder.begin(), 0);
+            m_freeViewIds.clear();
+            for (bgfx::ViewId viewId = m_viewIdCount; viewId-- > FirstViewId;)
+            {
+                if (std::find(m_viewOrder.begin(), m_viewOrder.end(), viewId) == m_viewOrder.end())
+                {
+                    m_viewOrder.push_back(viewId);
+                }
+                m_freeViewIds.push_back(viewId);
+            }
+            bgfx::setViewOrder(0, m_viewIdCount, m_viewOrder.data());
+            m_viewOrder.clear();
+
             m_activeFrameBuffers.apply_to_all([](auto frameBufferData) {
                 frameBufferData->IsViewIdDirty = true;
             });
         }
 
+        // The number of views used by the last frame, and how many more it would have needed without recycling.
+        uint32_t GetViewsUsed() const
+        {
+            return m_viewsUsed;
+        }
+
+        uint32_t GetViewsRecycled() const
+        {
+            return m_viewsRecycled;
+        }
+
         bool IsRenderingToTarget() const
         {
             return m_renderingToTarget;
         }
 
     private:
+        void RecycleBoundViewIfUnused()
+        {
+            if (m_boundFrameBuffer == nullptr || m_boundFrameBuffer->IsViewIdDirty || m_boundFrameBuffer->IsViewUsed)
+            {
+                return;
+            }
+
+            const auto it = std::find(m_viewOrder.begin(), m_viewOrder.end(), m_boundFrameBuffer->ViewId);
+            if (it != m_viewOrder.end())
+            {
+                m_viewOrder.erase(it);
+                m_freeViewIds.push_back(m_boundFrameBuffer->ViewId);
+                m_boundFrameBuffer->IsViewIdDirty = true;
+                ++m_viewsRecycledInFrame;
+            }
+        }
+
+        Napi::Env m_env;
         FrameBufferData* m_boundFrameBuffer{nullptr};
         FrameBufferData* m_defaultBackBuffer{nullptr};
         arcana::weak_table<FrameBufferData*> m_activeFrameBuffers{};
-        uint16_t m_nextId{0};
+        // Views handed out during the current frame, in execution order.
+        std::vector<bgfx::ViewId> m_viewOrder{};
+        // View 0 belongs to Graphics, which clears the back buffer with it before anything else is rendered.
+        static constexpr bgfx::ViewId FirstViewId{1};
+        // Views available to be handed out, the next one last.
+        std::vector<bgfx::ViewId> m_freeViewIds{};
+        // Views with ids at or above this have never been handed out.
+        bgfx::ViewId m_viewIdCount{FirstViewId};
+        uint32_t m_viewsRecycledInFrame{0};
+        uint32_t m_viewsUsed{0};
+        uint32_t m_viewsRecycled{0};
         bool m_renderingToTarget{false};
     };
 
@@ -346,17 +455,54 @@ namespace Babylon
         uint8_t Stage{};
         bgfx::UniformHandle Handle{bgfx::kInvalidHandle};
         bool YFlip{false};
+        // Index of the uniform's storage in the owning program's ProgramData::UniformSlots.
+        uint16_t Slot{};
+        // For uniforms the shader compiler packed into a shared vec4, the first component and the number of
+        // components of the vec4 the uniform occupies. Zero components means the uniform isn't packed.
+        uint8_t PackedComponent{};
+        uint8_t PackedComponents{};
     };
 
     struct ProgramData final
     {
-        ProgramData() = default;
+        ProgramData(ShaderHandleCache& shaderCache, CommandObjectRegistry& commandObjects)
+            : m_shaderCache{shaderCache}
+            , m_commandObjects{commandObjects}
+        {
+        }
+
         ProgramData(const ProgramData&) = delete;
         ProgramData(ProgramData&&) = delete;
 
         ~ProgramData()
         {
+            // The shaders may be shared with other programs, so they are released rather than destroyed along
+            // with the program.
             bgfx::destroy(Program);
+            m_shaderCache.Release(VertexShader);
+            m_shaderCache.Release(FragmentShader);
+
+            m_commandObjects.Remove(this);
+            for (const auto* uniformInfos : {&VertexUniformInfos, &FragmentUniformInfos})
+            {
+                for (const auto& uniformInfo : *uniformInfos)
+                {
+                    m_commandObjects.Remove(&uniformInfo.second);
+                }
+            }
+        }
+
+        // Registers the program and its uniforms once they are all known, so that commands can reference them.
+        void RegisterCommandObjects()
+        {
+            m_commandObjects.Add(this);
+            for (const auto* uniformInfos : {&VertexUniformInfos, &FragmentUniformInfos})
+            {
+                for (const auto& uniformInfo : *uniformInfos)
+                {
+                    m_commandObjects.Add(&uniformInfo.second);
+                }
+            }
         }
 
         std::unordered_map<std::string, uint32_t> VertexAttributeLocations{};
@@ -364,35 +510,246 @@ namespace Babylon
         std::unordered_map<std::string, UniformInfo> FragmentUniformInfos{};
 
         bgfx::ProgramHandle Program{};
+        bgfx::ShaderHandle VertexShader{bgfx::kInvalidHandle};
+        bgfx::ShaderHandle FragmentShader{bgfx::kInvalidHandle};
 
-        struct UniformValue
+        // The values of all the program's non-sampler uniforms live in one contiguous block, each uniform
+        // owning a fixed range of it sized from its declaration in the shader. Setting a uniform to the
+        // value it already holds does not mark it dirty, so draws only upload the uniforms that changed.
+        struct UniformSlot
         {
-            std::vector<float> Data{};
+            bgfx::UniformHandle Handle{bgfx::kInvalidHandle};
+            uint32_t Offset{};
+            uint16_t ElementSize{};
+            uint16_t MaxElements{};
             uint16_t ElementLength{};
+            // For matrices which must be flipped when rendering to a texture, the offset of the flipped copy
+            // of the value, which is kept up to date alongside the value itself.
+            uint32_t FlippedOffset{};
             bool YFlip{false};
+            bool Dirty{false};
         };
 
-        std::unordered_map<uint16_t, UniformValue> Uniforms{};
+        std::vector<UniformSlot> UniformSlots{};
+        std::vector<float> UniformData{};
+        std::vector<uint16_t> DirtyUniformSlots{};
+
+        uint16_t AddUniformSlot(bgfx::UniformHandle handle, const bgfx::UniformInfo& info, bool YFlip)
+        {
+            // Uniforms used by both stages share the same handle and therefore the same slot.
+            const auto existing = FindUniformSlot(handle);
+            if (existing < UniformSlots.size())
+            {
+                return existing;
+            }
+
+            UniformSlot& slot = UniformSlots.emplace_back();
+            slot.Handle = handle;
+            slot.Offset = static_cast<uint32_t>(UniformData.size());
+            slot.ElementSize = static_cast<uint16_t>(info.type == bgfx::UniformType::Mat4 ? 16 : (info.type == bgfx::UniformType::Mat3 ? 9 : 4));
+            slot.MaxElements = std::max<uint16_t>(info.num, 1);
+            slot.YFlip = YFlip && info.type == bgfx::UniformType::Mat4;
+
+            UniformData.resize(UniformData.size() + size_t{slot.ElementSize} * slot.MaxElements);
+            if (slot.YFlip)
+            {
+                slot.FlippedOffset = static_cast<uint32_t>(UniformData.size());
+                UniformData.resize(UniformData.size() + 16);
+            }
+            return static_cast<uint16_t>(UniformSlots.size() - 1);
+        }
+
+        uint16_t FindUniformSlot(bgfx::UniformHandle handle) const
+        {
+            for (size_t index = 0; index < UniformSlots.size(); ++index)
+            {
+                if (UniformSlots[index].Handle.idx == handle.idx)
+                {
+                    return static_cast<uint16_t>(index);
+                }
+            }
+            return static_cast<uint16_t>(UniformSlots.size());
+        }
+
+        void SetUniform(const UniformInfo& info, gsl::span<const float> data, size_t elementLength = 1)
+        {
+            if (info.PackedComponents != 0)
+            {
+                SetPackedUniform(info, data);
+                return;
+            }
+
+            // The uniform info normally belongs to this program, but fall back to a lookup by handle
+            // in case it was obtained from another program sharing the uniform.
+            uint16_t slotIndex = info.Slot;
+            if (slotIndex >= UniformSlots.size() || UniformSlots[slotIndex].Handle.idx != info.Handle.idx)
+            {
+                slotIndex = FindUniformSlot(info.Handle);
+                if (slotIndex >= UniformSlots.size())
+                {
+                    // The uniform isn't used by this program.
+                    return;
+                }
+            }
+
+            UniformSlot& slot = UniformSlots[slotIndex];
+            const auto newElementLength = static_cast<uint16_t>(std::min<size_t>(elementLength, slot.MaxElements));
+            const size_t count = std::min<size_t>(static_cast<size_t>(data.size()), size_t{slot.ElementSize} * slot.MaxElements);
+            float* values = UniformData.data() + slot.Offset;
+
+            if (newElementLength == slot.ElementLength && std::memcmp(values, data.data(), count * sizeof(float)) == 0)
+            {
+                return;
+            }
+
+            std::memcpy(values, data.data(), count * sizeof(float));
+            slot.ElementLength = newElementLength;
+
+            if (slot.YFlip)
+            {
+                static const float flipMatrix[16] = {1.f, 0.f, 0.f, 0.f,
+                    0.f, -1.f, 0.f, 0.f,
+                    0.f, 0.f, 1.f, 0.f,
+                    0.f, 0.f, 0.f, 1.f};
+                MultiplyMatrix4x4(UniformData.data() + slot.FlippedOffset, values, flipMatrix);
+            }
+
+            if (!slot.Dirty)
+            {
+                slot.Dirty = true;
+                DirtyUniformSlots.push_back(slotIndex);
+            }
+        }
+
+        // Packed uniforms only own some of the components of their slot, so they are scattered into it rather
+        // than copied over it. Packed uniforms are named after their layout, so as with SetUniform, a uniform
+        // info from another program sharing the packed uniform has the same components in this program.
+        void SetPackedUniform(const UniformInfo& info, gsl::span<const float> data)
+        {
+            uint16_t slotIndex = info.Slot;
+            if (slotIndex >= UniformSlots.size() || UniformSlots[slotIndex].Handle.idx != info.Handle.idx)
+            {
+                slotIndex = FindUniformSlot(info.Handle);
+                if (slotIndex >= UniformSlots.size())
+                {
+                    return;
+                }
+            }
+
+            UniformSlot& slot = UniformSlots[slotIndex];
+            const size_t count = std::min<size_t>(static_cast<size_t>(data.size()), info.PackedComponents);
+            float* values = UniformData.data() + slot.Offset + info.PackedComponent;
+
+            if (slot.ElementLength == 1 && std::memcmp(values, data.data(), count * sizeof(float)) == 0)
+            {
+                return;
+            }
+
+            std::memcpy(values, data.data(), count * sizeof(float));
+            slot.ElementLength = 1;
+
+            if (!slot.Dirty)
+            {
+                slot.Dirty = true;
+                DirtyUniformSlots.push_back(slotIndex);
+            }
+        }
+
+        // Sets the program's uniforms on bgfx for the next draw. bgfx retains uniform values from one draw
+        // to the next, so when the previous draw used this same program only the dirty uniforms need to be
+        // set; otherwise all of them are. Returns the number of bytes uploaded.
+        size_t UploadUniforms(bool uploadAll, bool YFlip)
+        {
+            size_t uploadedBytes{0};
+
+            const auto upload = [this, YFlip, &uploadedBytes](UniformSlot& slot) {
+                slot.Dirty = false;
+                if (slot.ElementLength == 0)
+                {
+                    // The uniform was never set.
+                    return;
+                }
+
+                if (YFlip && slot.YFlip)
+                {
+                    bgfx::setUniform(slot.Handle, UniformData.data() + slot.FlippedOffset, 1);
+                    uploadedBytes += 16 * sizeof(float);
+                }
+                else
+                {
+                    bgfx::setUniform(slot.Handle, UniformData.data() + slot.Offset, slot.ElementLength);
+                    uploadedBytes += size_t{slot.ElementLength} * slot.ElementSize * sizeof(float);
+                }
+            };
+
+            if (uploadAll)
+            {
+                for (auto& slot : UniformSlots)
+                {
+                    upload(slot);
+                }
+            }
+            else
+            {
+                for (const auto slotIndex : DirtyUniformSlots)
+                {
+                    upload(UniformSlots[slotIndex]);
+                }
+            }
+
+            DirtyUniformSlots.clear();
+            return uploadedBytes;
+        }
 
-        void SetUniform(bgfx::UniformHandle handle, gsl::span<const float> data, bool YFlip, size_t elementLength = 1)
+    private:
+        // Same as bx::mtxMul, four lanes at a time.
+        static void MultiplyMatrix4x4(float* result, const float* a, const float* b)
         {
-            UniformValue& value = Uniforms[handle.idx];
-            value.Data.assign(data.begin(), data.end());
-            value.ElementLength = static_cast<uint16_t>(elementLength);
-            value.YFlip = YFlip;
+            // bx::simd_ld and bx::simd_st require 16-byte aligned memory, which the uniform block doesn't guarantee.
+            alignas(16) float alignedA[16];
+            alignas(16) float alignedB[16];
+            alignas(16) float alignedResult[16];
+            std::memcpy(alignedA, a, sizeof(alignedA));
+            std::memcpy(alignedB, b, sizeof(alignedB));
+
+            const auto b0 = bx::simd_ld<bx::simd128_t>(&alignedB[0]);
+            const auto b1 = bx::simd_ld<bx::simd128_t>(&alignedB[4]);
+            const auto b2 = bx::simd_ld<bx::simd128_t>(&alignedB[8]);
+            const auto b3 = bx::simd_ld<bx::simd128_t>(&alignedB[12]);
+
+            for (size_t row = 0; row < 4; ++row)
+            {
+                const auto aRow = bx::simd_ld<bx::simd128_t>(&alignedA[row * 4]);
+                auto resultRow = bx::simd_mul(bx::simd_swiz_xxxx(aRow), b0);
+                resultRow = bx::simd_madd(bx::simd_swiz_yyyy(aRow), b1, resultRow);
+                resultRow = bx::simd_madd(bx::simd_swiz_zzzz(aRow), b2, resultRow);
+                resultRow = bx::simd_madd(bx::simd_swiz_wwww(aRow), b3, resultRow);
+                bx::simd_st(&alignedResult[row * 4], resultRow);
+            }
+
+            std::memcpy(result, alignedResult, sizeof(alignedResult));
         }
+
+        ShaderHandleCache& m_shaderCache;
+        CommandObjectRegistry& m_commandObjects;
     };
 
     class IndexBufferData;
     class VertexBufferData;
+    class PinnedJsMemoryReleaseQueue;
 
     struct VertexArray final
     {
+        VertexArray(VertexLayoutCache& layoutCache)
+            : m_layoutCache{layoutCache}
+        {
+        }
+
         ~VertexArray()
         {
             for (auto& vertexBufferPair : vertexBuffers)
             {
-                bgfx::destroy(vertexBufferPair.second.vertexLayoutHandle);
+                m_layoutCache.Release(vertexBufferPair.second.vertexLayoutHandle);
             }
         }
 
@@ -411,6 +768,147 @@ namespace Babylon
         };
 
         std::unordered_map<uint32_t, VertexBuffer> vertexBuffers;
+
+        void RecordVertexBuffer(uint32_t location, const VertexBufferData* data, uint32_t startVertex, const bgfx::VertexLayout& layout)
+        {
+            const bgfx::VertexLayoutHandle layoutHandle = m_layoutCache.Acquire(layout, [&layout] { return bgfx::createVertexLayout(layout); });
+
+            const auto it = vertexBuffers.find(location);
+            if (it != vertexBuffers.end())
+            {
+                m_layoutCache.Release(it->second.vertexLayoutHandle);
+            }
+
+            vertexBuffers[location] = {data, startVertex, layoutHandle};
+        }
+
+    private:
+        VertexLayoutCache& m_layoutCache;
+    };
+
+    // Geometry stored in bgfx's transient buffers, for geometry rebuilt every frame. The buffers are only valid
+    // during the frame they were allocated in, but the attribute layout recorded for the geometry persists so
+    // that it can be allocated again frame after frame. JavaScript writes into buffers of its own, which are
+    // copied into the transient buffers when the geometry is first drawn, since bgfx hands the transient
+    // buffers over to the renderer at the end of the frame.
+    struct TransientGeometry final
+    {
+        TransientGeometry(VertexLayoutCache& layoutCache)
+            : m_layoutCache{layoutCache}
+        {
+        }
+
+        ~TransientGeometry()
+        {
+            for (auto& attributePair : attributes)
+            {
+                m_layoutCache.Release(attributePair.second.vertexLayoutHandle);
+            }
+        }
+
+        bgfx::TransientVertexBuffer vertexBuffer{};
+        bgfx::TransientIndexBuffer indexBuffer{};
+        uint32_t indexCount{};
+        // The NativeEngine frame the buffers were allocated in.
+        uint64_t frameId{UINT64_MAX};
+
+        // The buffers JavaScript writes into, reused by the next allocation if it has the same sizes.
+        Napi::Reference<Napi::ArrayBuffer> vertexData{};
+        Napi::Reference<Napi::ArrayBuffer> indexData{};
+        bool uploaded{false};
+
+        void Upload(Napi::Env env)
+        {
+            if (uploaded)
+            {
+                return;
+            }
+
+            const auto vertices = vertexData.Value();
+            const auto indices = indexData.Value();
+            const size_t indexBytes = size_t{indexCount} * sizeof(uint16_t);
+            if (vertices.ByteLength() != vertexBuffer.size || indices.ByteLength() != indexBytes)
+            {
+                throw Napi::Error::New(env, "Transient geometry buffers were resized after they were allocated.");
+            }
+
+            std::memcpy(vertexBuffer.data, vertices.Data(), vertexBuffer.size);
+            if (indexBytes > 0)
+            {
+                std::memcpy(indexBuffer.data, indices.Data(), indexBytes);
+            }
+            uploaded = true;
+        }
+
+        struct Attribute
+        {
+            uint32_t startVertex{};
+            bgfx::VertexLayoutHandle vertexLayoutHandle{};
+        };
+
+        std::unordered_map<uint32_t, Attribute> attributes;
+
+        void RecordAttribute(uint32_t location, uint32_t startVertex, const bgfx::VertexLayout& layout)
+        {
+            const bgfx::VertexLayoutHandle layoutHandle = m_layoutCache.Acquire(layout, [&layout] { return bgfx::createVertexLayout(layout); });
+
+            const auto it = attributes.find(location);
+            if (it != attributes.end())
+            {
+                m_layoutCache.Release(it->second.vertexLayoutHandle);
+            }
+
+            attributes[location] = {startVertex, layoutHandle};
+        }
+
+    private:
+        VertexLayoutCache& m_layoutCache;
+    };
+
+    // Per-instance data stored in a bgfx instance data buffer. As with transient geometry, the buffer is only
+    // valid during the frame it was allocated in, and JavaScript writes into a buffer of its own, which is
+    // copied into the instance data buffer when it is first drawn.
+    struct InstanceData final
+    {
+        bgfx::InstanceDataBuffer buffer{};
+        // The NativeEngine frame the buffer was allocated in.
+        uint64_t frameId{UINT64_MAX};
+
+        // The buffer JavaScript writes into, reused by the next allocation if it has the same size.
+        Napi::Reference<Napi::ArrayBuffer> data{};
+        bool uploaded{false};
+
+        void Upload(Napi::Env env)
+        {
+            if (uploaded)
+            {
+                return;
+            }
+
+            const auto values = data.Value();
+            if (values.ByteLength() != buffer.size)
+            {
+                throw Napi::Error::New(env, "Instance data buffer was resized after it was allocated.");
+            }
+
+            std::memcpy(buffer.data, values.Data(), buffer.size);
+            uploaded = true;
+        }
+    };
+
+    // Counters describing the work NativeEngine did over the course of a frame.
+    struct FrameStats final
+    {
+        uint64_t UniformBytesUploaded{};
+        uint64_t DynamicVertexBytesUploaded{};
+        uint64_t TransientBytesAllocated{};
+        uint32_t InstancesDrawn{};
+        uint32_t ViewsUsed{};
+        uint32_t ViewsRecycled{};
+        uint32_t RedundantStateSetsSkipped{};
+        uint32_t RedundantVertexBufferSetsSkipped{};
+        uint32_t RedundantIndexBufferSetsSkipped{};
+        uint32_t RedundantTextureSetsSkipped{};
     };
 
     class NativeEngine final : public Napi::ObjectWrap<NativeEngine>
@@ -425,15 +923,29 @@ namespace Babylon
         ~NativeEngine();
 
         static void Initialize(Napi::Env, bool autoRender);
+        static void EnableShaderOptimization(bool enabled);
 
         FrameBufferManager& GetFrameBufferManager();
-        void Dispatch(std::function<void()>);
+
+        template<typename CallableT>
+        void Dispatch(CallableT callable, JsRuntime::DispatchPriority priority = JsRuntime::DispatchPriority::Normal)
+        {
+            m_runtime.Dispatch([callable = std::move(callable)](Napi::Env) mutable {
+                callable();
+            }, priority);
+        }
 
         // IMPORTANT: Must be called from the JS thread.
         void ScheduleRender();
 
+        // Forgets everything NativeEngine assumes bgfx retained from previous draws. Must be called after
+        // anything other than NativeEngine calls bgfx::frame or bgfx::discard.
+        void InvalidateBgfxState();
+
         const bool AutomaticRenderingEnabled{};
         JsRuntimeScheduler RuntimeScheduler;
+        // For work which frames wait on, such as requestAnimationFrame callbacks.
+        JsRuntimeScheduler FrameRuntimeScheduler;
 
     private:
         void Dispose();
@@ -453,7 +965,20 @@ namespace Babylon
         void DeleteVertexBuffer(const Napi::CallbackInfo& info);
         void RecordVertexBuffer(const Napi::CallbackInfo& info);
         void UpdateDynamicVertexBuffer(const Napi::CallbackInfo& info);
+        Napi::Value CreateTransientGeometry(const Napi::CallbackInfo& info);
+        void DeleteTransientGeometry(const Napi::CallbackInfo& info);
+        Napi::Value AllocateTransientGeometry(const Napi::CallbackInfo& info);
+        void RecordTransientVertexBuffer(const Napi::CallbackInfo& info);
+        void DrawTransient(const Napi::CallbackInfo& info);
+        Napi::Value CreateInstanceData(const Napi::CallbackInfo& info);
+        void DeleteInstanceData(const Napi::CallbackInfo& info);
+        Napi::Value AllocateInstanceData(const Napi::CallbackInfo& info);
+        void SetInstanceData(const Napi::CallbackInfo& info);
+        void SetInstanceDataBuffer(const Napi::CallbackInfo& info);
+        void DrawInstanced(const Napi::CallbackInfo& info);
+        void MultiDrawIndexed(const Napi::CallbackInfo& info);
         Napi::Value CreateProgram(const Napi::CallbackInfo& info);
+        void CreateProgramAsync(const Napi::CallbackInfo& info);
         Napi::Value GetUniforms(const Napi::CallbackInfo& info);
         Napi::Value GetAttributes(const Napi::CallbackInfo& info);
         void SetProgram(const Napi::CallbackInfo& info);
@@ -508,26 +1033,86 @@ namespace Babylon
         Napi::Value GetRenderAPI(const Napi::CallbackInfo& info);
         Napi::Value GetHardwareScalingLevel(const Napi::CallbackInfo& info);
         void SetHardwareScalingLevel(const Napi::CallbackInfo& info);
+        void SubmitCommands(const Napi::CallbackInfo& info);
+        Napi::Value GetFrameStats(const Napi::CallbackInfo& info);
+        Napi::Value GetShaderCompilationProfile(const Napi::CallbackInfo& info);
+        void ResetShaderCompilationProfile(const Napi::CallbackInfo& info);
+
+        // Can be called from any thread, so it takes all it uses rather than reading it from the engine.
+        static ShaderCompiler::BgfxShaderInfo CompileShaders(ShaderCompiler& compiler, const std::string& cacheDirectory, std::string_view vertexSource, std::string_view fragmentSource);
+
+        // Implementations shared by the individual JS methods above and the command buffer path.
+        Napi::Value CreateProgramInternal(Napi::Env env, const ShaderCompiler::BgfxShaderInfo& shaderInfo);
+        void SetProgramInternal(ProgramData* program);
+        void SetStateInternal(bool culling, bool cullBackFaces, bool reverseSide);
+        void SetDepthTestInternal(uint32_t depthTest);
+        void SetDepthWriteInternal(bool enable);
+        void SetColorWriteInternal(bool enable);
+        void SetBlendModeInternal(uint64_t blendMode);
+        void SetTextureInternal(const UniformInfo& uniformInfo, const TextureData& texture);
+        void BindVertexArrayInternal(const VertexArray& vertexArray);
+        void DrawIndexedInternal(int32_t fillMode, int32_t elementStart, int32_t elementCount);
+        void DrawInternal(int32_t fillMode, int32_t verticesStart, int32_t verticesCount);
+        void MultiDrawIndexedInternal(int32_t fillMode, gsl::span<const int32_t> draws);
+        void UnbindVertexStreamsExcept(uint32_t streamMask);
+        void SubmitInternal(int32_t fillMode);
+        void ExecuteCommand(Command command, CommandBufferReader& reader);
 
         template<typename SchedulerT>
         arcana::task<void, std::exception_ptr> GetRequestAnimationFrameTask(SchedulerT&);
 
         bool m_isRenderScheduled{false};
+        // Incremented at the start of every frame.
+        uint64_t m_frameId{0};
 
         arcana::cancellation_source m_cancelSource{};
 
-        ShaderCompiler m_shaderCompiler;
+        // Shared with the asynchronous compilations, which can outlive the engine.
+        std::shared_ptr<ShaderCompiler> m_shaderCompiler;
+
+        struct ProgramCallbacks
+        {
+            Napi::FunctionReference OnSuccess;
+            Napi::FunctionReference OnError;
+        };
+
+        // Callbacks waiting on the asynchronous compilation of each pair of sources, keyed by the sources.
+        // Requesting a program whose sources are already being compiled waits on that compilation.
+        std::unordered_map<std::string, std::vector<ProgramCallbacks>> m_pendingPrograms{};
+
+        // Declared ahead of the programs so that they outlive them.
+        ShaderHandleCache m_shaderHandleCache{};
+        CommandObjectRegistry m_commandObjects{};
 
         ProgramData* m_currentProgram{nullptr};
         arcana::weak_table<std::unique_ptr<ProgramData>> m_programDataCollection{};
 
         JsRuntime& m_runtime;
+        // For the completion of texture loads, which can wait behind everything else.
+        JsRuntimeScheduler m_backgroundRuntimeScheduler;
         Graphics::Impl& m_graphicsImpl;
 
         bx::DefaultAllocator m_allocator;
         uint64_t m_engineState;
 
-        FrameBufferManager m_frameBufferManager{};
+        // Where bgfx returns the JavaScript memory of zero-copy buffers once it is done with it.
+        std::shared_ptr<PinnedJsMemoryReleaseQueue> m_pinnedMemoryReleaseQueue;
+
+        FrameBufferManager m_frameBufferManager;
+        VertexLayoutCache m_vertexLayoutCache{};
+        arcana::weak_table<VertexBufferData*> m_dynamicVertexBuffers{};
+
+        FrameStats m_frameStats{};
+        FrameStats m_previousFrameStats{};
+
+        // Describes the last draw submitted to bgfx, whose uniform values bgfx still holds. Views execute
+        // their draws in submission order, so a draw matching all of these can skip re-setting any uniform
+        // which didn't change since.
+        const ProgramData* m_lastSubmittedProgram{};
+        bgfx::ViewId m_lastSubmittedViewId{};
+        bool m_lastSubmittedYFlip{false};
+
+        ShadowState m_shadowState{};
 
         template<int size, typename arrayType>
         void SetTypeArrayN(const Napi::CallbackInfo& info);
@@ -538,6 +1123,17 @@ namespace Babylon
         template<int size>
         void SetMatrixN(const Napi::CallbackInfo& info);
 
+        template<int size, typename ElementT>
+        void SetUniformArrayN(const UniformInfo& uniformInfo, gsl::span<const ElementT> values);
+
+        template<int size>
+        void SetUniformFloatN(const UniformInfo& uniformInfo, const float* values);
+
+        template<int size>
+        void SetUniformMatrixN(const UniformInfo& uniformInfo, const float* values);
+
+        void SetUniformMatrices(const UniformInfo& uniformInfo, gsl::span<const float> values);
+
         // Scratch vector used for data alignment.
         std::vector<float> m_scratch{};
 
@@ -548,5 +1144,12 @@ namespace Babylon
         // at the time of webgl binding, we don't know those values yet
         // so a pointer to the to-bind buffer is kept and the buffer is bound to bgfx at the time of the drawcall
         const IndexBufferData* m_currentBoundIndexBuffer{};
+
+        // bgfx drops the instance data after every submit, so the instance data last set by setInstanceData
+        // or setInstanceDataBuffer is kept here and applied again to every instanced draw until the frame ends.
+        InstanceData* m_currentInstanceData{};
+        const VertexBufferData* m_currentInstanceBuffer{};
+        uint32_t m_currentInstanceStart{};
+        uint32_t m_currentInstanceCount{};
     };
 }
@@ -1,5 +1,11 @@
 #include <Babylon/Plugins/NativeEngine.h>
 #include "NativeEngine.h"
+#include "ShaderBundle.h"
+#include "ShaderCompilationProfiler.h"
+#include "ShaderSourceDump.h"
+
+#include <fstream>
+#include <iterator>
 
 namespace Babylon::Plugins::NativeEngine
 {
@@ -7,4 +13,36 @@ namespace Babylon::Plugins::NativeEngine
     {
         Babylon::NativeEngine::Initialize(env, renderAutomatically);
     }
+
+    void EnableShaderOptimization(bool enabled)
+    {
+        Babylon::NativeEngine::EnableShaderOptimization(enabled);
+    }
+
+    void MountShaderBundle(const std::string& path)
+    {
+        std::ifstream file{path, std::ios::binary};
+        if (!file)
+        {
+            throw std::runtime_error{"Unable to open shader bundle " + path + "."};
+        }
+
+        std::vector<uint8_t> bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        ShaderBundle::Mount(std::make_shared<const ShaderBundle::Bundle>(std::move(bytes)));
+    }
+
+    void DumpShaderSources(const std::string& directory)
+    {
+        ShaderSourceDump::SetDirectory(directory);
+    }
+
+    ShaderCompilationProfile GetShaderCompilationProfile()
+    {
+        return ShaderCompilationProfiler::Get();
+    }
+
+    void ResetShaderCompilationProfile()
+    {
+        ShaderCompilationProfiler::Reset();
+    }
 }
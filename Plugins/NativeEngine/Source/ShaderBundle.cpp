@@ -0,0 +1,130 @@
+#include "ShaderBundle.h"
+#include "ShaderCache.h"
+#include "ShaderCompilerCommon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace Babylon::ShaderBundle
+{
+    namespace
+    {
+        constexpr uint32_t Magic{0x42534E42}; // "BNSB"
+        // Must be incremented whenever the layout of the bundle changes.
+        constexpr uint32_t FormatVersion{1};
+
+        struct Header
+        {
+            uint32_t Magic;
+            uint32_t FormatVersion;
+            uint32_t EntryCount;
+            uint32_t Reserved;
+        };
+
+        std::mutex s_mountedBundlesMutex{};
+        std::vector<std::shared_ptr<const Bundle>> s_mountedBundles{};
+    }
+
+    std::vector<uint8_t> Build(const std::vector<std::pair<uint64_t, ShaderCompiler::BgfxShaderInfo>>& shaders)
+    {
+        std::vector<std::pair<uint64_t, std::vector<uint8_t>>> entries{};
+        entries.reserve(shaders.size());
+        for (const auto& [key, shaderInfo] : shaders)
+        {
+            entries.emplace_back(key, ShaderCache::Serialize(key, shaderInfo));
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const auto& left, const auto& right) { return left.first < right.first; });
+        entries.erase(std::unique(entries.begin(), entries.end(), [](const auto& left, const auto& right) { return left.first == right.first; }), entries.end());
+
+        std::vector<uint8_t> bytes{};
+        ShaderCompilerCommon::AppendBytes(bytes, Header{Magic, FormatVersion, static_cast<uint32_t>(entries.size()), 0});
+
+        size_t offset{sizeof(Header) + entries.size() * sizeof(uint64_t[2])};
+        for (const auto& [key, entry] : entries)
+        {
+            if (offset + entry.size() > UINT32_MAX)
+            {
+                throw std::runtime_error{"Shader bundle exceeds 4GB."};
+            }
+
+            ShaderCompilerCommon::AppendBytes(bytes, key);
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(offset));
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(entry.size()));
+            offset += entry.size();
+        }
+
+        for (const auto& entry : entries)
+        {
+            bytes.insert(bytes.end(), entry.second.begin(), entry.second.end());
+        }
+
+        return bytes;
+    }
+
+    Bundle::Bundle(std::vector<uint8_t> bytes)
+        : m_bytes{std::move(bytes)}
+    {
+        static_assert(sizeof(Entry) == sizeof(uint64_t[2]));
+
+        Header header;
+        if (m_bytes.size() < sizeof(header))
+        {
+            throw std::runtime_error{"Invalid shader bundle."};
+        }
+        std::memcpy(&header, m_bytes.data(), sizeof(header));
+
+        if (header.Magic != Magic || header.FormatVersion != FormatVersion)
+        {
+            throw std::runtime_error{"Invalid or outdated shader bundle."};
+        }
+
+        if ((m_bytes.size() - sizeof(header)) / sizeof(Entry) < header.EntryCount)
+        {
+            throw std::runtime_error{"Truncated shader bundle."};
+        }
+
+        // std::vector storage is suitably aligned for any fundamental type, and so is the table at offset 16.
+        m_entries = gsl::make_span(reinterpret_cast<const Entry*>(m_bytes.data() + sizeof(header)), header.EntryCount);
+        for (const Entry& entry : m_entries)
+        {
+            if (size_t{entry.Offset} + entry.Size > m_bytes.size())
+            {
+                throw std::runtime_error{"Truncated shader bundle."};
+            }
+        }
+    }
+
+    std::optional<ShaderCompiler::BgfxShaderInfo> Bundle::Find(uint64_t key) const
+    {
+        const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, [](const Entry& entry, uint64_t value) { return entry.Key < value; });
+        if (it == m_entries.end() || it->Key != key)
+        {
+            return {};
+        }
+
+        return ShaderCache::Deserialize(key, gsl::make_span(m_bytes.data() + it->Offset, it->Size));
+    }
+
+    void Mount(std::shared_ptr<const Bundle> bundle)
+    {
+        std::scoped_lock lock{s_mountedBundlesMutex};
+        s_mountedBundles.push_back(std::move(bundle));
+    }
+
+    std::optional<ShaderCompiler::BgfxShaderInfo> FindMounted(uint64_t key)
+    {
+        std::scoped_lock lock{s_mountedBundlesMutex};
+        for (const auto& bundle : s_mountedBundles)
+        {
+            if (auto shaderInfo{bundle->Find(key)})
+            {
+                return shaderInfo;
+            }
+        }
+
+        return {};
+    }
+}
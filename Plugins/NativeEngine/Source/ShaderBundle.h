@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ShaderCompiler.h"
+
+#include <gsl/gsl>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Babylon::ShaderBundle
+{
+    // A bundle packs precompiled shaders into a single file: a header ("BNSB", the format version, and the
+    // number of entries), a table of entries (key, offset, and size) sorted by key, and then the entries
+    // themselves, in the ShaderCache entry format. Keys are computed by ShaderCache::ComputeKey, so a bundle
+    // only serves the graphics API and compiler version it was built for.
+    std::vector<uint8_t> Build(const std::vector<std::pair<uint64_t, ShaderCompiler::BgfxShaderInfo>>& shaders);
+
+    class Bundle final
+    {
+    public:
+        // Throws if the bytes aren't a valid bundle.
+        explicit Bundle(std::vector<uint8_t> bytes);
+
+        std::optional<ShaderCompiler::BgfxShaderInfo> Find(uint64_t key) const;
+
+    private:
+        struct Entry
+        {
+            uint64_t Key;
+            uint32_t Offset;
+            uint32_t Size;
+        };
+
+        std::vector<uint8_t> m_bytes;
+        gsl::span<const Entry> m_entries{};
+    };
+
+    // Mounted bundles are shared by all the NativeEngine instances of the process.
+    void Mount(std::shared_ptr<const Bundle> bundle);
+    std::optional<ShaderCompiler::BgfxShaderInfo> FindMounted(uint64_t key);
+}
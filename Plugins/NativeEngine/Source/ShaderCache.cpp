@@ -0,0 +1,234 @@
+#include "ShaderCache.h"
+#include "ShaderCompilerCommon.h"
+
+#include <bgfx/defines.h>
+
+#include <CacheUtils/CacheUtils.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace Babylon::ShaderCache
+{
+    namespace
+    {
+        constexpr uint32_t Magic{0x43534E42}; // "BNSC"
+        // Must be incremented whenever the layout of the entries below changes.
+        constexpr uint32_t FormatVersion{2};
+
+#if APID3D
+        constexpr std::string_view TargetApi{"D3D"};
+#elif APIMetal
+        constexpr std::string_view TargetApi{"Metal"};
+#else
+        constexpr std::string_view TargetApi{"OpenGL"};
+#endif
+
+        std::string GetPath(const std::string& directory, uint64_t key)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/%016llx.shader", static_cast<unsigned long long>(key));
+            return directory + name;
+        }
+
+        template<typename ValueT>
+        void AppendValue(std::vector<uint8_t>& bytes, const ValueT& value)
+        {
+            ShaderCompilerCommon::AppendBytes(bytes, value);
+        }
+
+        void AppendValue(std::vector<uint8_t>& bytes, const ShaderCompiler::PackedUniform& packedUniform)
+        {
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(packedUniform.Name.size()));
+            ShaderCompilerCommon::AppendBytes(bytes, packedUniform.Name);
+            ShaderCompilerCommon::AppendBytes(bytes, packedUniform.Component);
+            ShaderCompilerCommon::AppendBytes(bytes, packedUniform.Components);
+        }
+
+        template<typename ValueT>
+        void AppendMap(std::vector<uint8_t>& bytes, const std::unordered_map<std::string, ValueT>& map)
+        {
+            ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(map.size()));
+            for (const auto& [name, value] : map)
+            {
+                ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(name.size()));
+                ShaderCompilerCommon::AppendBytes(bytes, name);
+                AppendValue(bytes, value);
+            }
+        }
+
+        class EntryReader final
+        {
+        public:
+            EntryReader(gsl::span<const uint8_t> bytes)
+                : m_bytes{bytes}
+            {
+            }
+
+            template<typename ValueT>
+            bool Read(ValueT& value)
+            {
+                if (static_cast<size_t>(m_bytes.size()) - m_position < sizeof(ValueT))
+                {
+                    return false;
+                }
+
+                std::memcpy(&value, m_bytes.data() + m_position, sizeof(ValueT));
+                m_position += sizeof(ValueT);
+                return true;
+            }
+
+            bool Read(std::vector<uint8_t>& data)
+            {
+                uint32_t size;
+                if (!Read(size) || static_cast<size_t>(m_bytes.size()) - m_position < size)
+                {
+                    return false;
+                }
+
+                data.assign(m_bytes.data() + m_position, m_bytes.data() + m_position + size);
+                m_position += size;
+                return true;
+            }
+
+            bool Read(std::string& string)
+            {
+                uint32_t size;
+                if (!Read(size) || static_cast<size_t>(m_bytes.size()) - m_position < size)
+                {
+                    return false;
+                }
+
+                string.assign(reinterpret_cast<const char*>(m_bytes.data() + m_position), size);
+                m_position += size;
+                return true;
+            }
+
+            bool Read(ShaderCompiler::PackedUniform& packedUniform)
+            {
+                return Read(packedUniform.Name) && Read(packedUniform.Component) && Read(packedUniform.Components);
+            }
+
+            template<typename ValueT>
+            bool Read(std::unordered_map<std::string, ValueT>& map)
+            {
+                uint32_t count;
+                if (!Read(count))
+                {
+                    return false;
+                }
+
+                for (uint32_t index = 0; index < count; ++index)
+                {
+                    std::string name;
+                    ValueT value;
+                    if (!Read(name) || !Read(value))
+                    {
+                        return false;
+                    }
+                    map.emplace(std::move(name), value);
+                }
+                return true;
+            }
+
+            bool IsAtEnd() const
+            {
+                return m_position == static_cast<size_t>(m_bytes.size());
+            }
+
+        private:
+            gsl::span<const uint8_t> m_bytes;
+            size_t m_position{0};
+        };
+    }
+
+    uint64_t ComputeKey(std::string_view vertexSource, std::string_view fragmentSource, const ShaderCompiler::Options& options)
+    {
+        uint64_t hash{CacheUtils::Fnv1aOffsetBasis};
+
+        // The sizes keep the boundaries between the strings unambiguous.
+        for (const std::string_view string : {vertexSource, fragmentSource, TargetApi})
+        {
+            const uint64_t size{string.size()};
+            hash = CacheUtils::Fnv1a(&size, sizeof(size), hash);
+            hash = CacheUtils::Fnv1a(string.data(), string.size(), hash);
+        }
+
+        const uint32_t versions[] = {FormatVersion, ShaderCompiler::Version, BGFX_API_VERSION};
+        hash = CacheUtils::Fnv1a(versions, sizeof(versions), hash);
+
+        const uint8_t optimizeSpirv{static_cast<uint8_t>(options.OptimizeSpirv)};
+        hash = CacheUtils::Fnv1a(&optimizeSpirv, sizeof(optimizeSpirv), hash);
+
+        return hash;
+    }
+
+    std::vector<uint8_t> Serialize(uint64_t key, const ShaderCompiler::BgfxShaderInfo& shaderInfo)
+    {
+        std::vector<uint8_t> bytes{};
+        ShaderCompilerCommon::AppendBytes(bytes, Magic);
+        ShaderCompilerCommon::AppendBytes(bytes, FormatVersion);
+        ShaderCompilerCommon::AppendBytes(bytes, key);
+        ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(shaderInfo.VertexBytes.size()));
+        bytes.insert(bytes.end(), shaderInfo.VertexBytes.begin(), shaderInfo.VertexBytes.end());
+        AppendMap(bytes, shaderInfo.VertexAttributeLocations);
+        AppendMap(bytes, shaderInfo.VertexUniformStages);
+        ShaderCompilerCommon::AppendBytes(bytes, static_cast<uint32_t>(shaderInfo.FragmentBytes.size()));
+        bytes.insert(bytes.end(), shaderInfo.FragmentBytes.begin(), shaderInfo.FragmentBytes.end());
+        AppendMap(bytes, shaderInfo.FragmentUniformStages);
+        AppendMap(bytes, shaderInfo.PackedUniforms);
+        return bytes;
+    }
+
+    std::optional<ShaderCompiler::BgfxShaderInfo> Deserialize(uint64_t key, gsl::span<const uint8_t> bytes)
+    {
+        EntryReader reader{bytes};
+
+        uint32_t magic;
+        uint32_t formatVersion;
+        uint64_t entryKey;
+        if (!reader.Read(magic) || magic != Magic ||
+            !reader.Read(formatVersion) || formatVersion != FormatVersion ||
+            !reader.Read(entryKey) || entryKey != key)
+        {
+            return {};
+        }
+
+        ShaderCompiler::BgfxShaderInfo shaderInfo{};
+        if (!reader.Read(shaderInfo.VertexBytes) ||
+            !reader.Read(shaderInfo.VertexAttributeLocations) ||
+            !reader.Read(shaderInfo.VertexUniformStages) ||
+            !reader.Read(shaderInfo.FragmentBytes) ||
+            !reader.Read(shaderInfo.FragmentUniformStages) ||
+            !reader.Read(shaderInfo.PackedUniforms) ||
+            !reader.IsAtEnd())
+        {
+            return {};
+        }
+
+        return shaderInfo;
+    }
+
+    std::optional<ShaderCompiler::BgfxShaderInfo> Read(const std::string& directory, uint64_t key)
+    {
+        std::ifstream file{GetPath(directory, key), std::ios::binary};
+        if (!file)
+        {
+            return {};
+        }
+
+        const std::vector<uint8_t> bytes{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+        return Deserialize(key, bytes);
+    }
+
+    void Write(const std::string& directory, uint64_t key, const ShaderCompiler::BgfxShaderInfo& shaderInfo)
+    {
+        const std::vector<uint8_t> bytes{Serialize(key, shaderInfo)};
+
+        // Concurrent writers of the same entry, possibly from other processes, must never let a reader see a
+        // partially written file.
+        CacheUtils::WriteFileAtomically(GetPath(directory, key), bytes.data(), bytes.size());
+    }
+}
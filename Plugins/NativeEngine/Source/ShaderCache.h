@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ShaderCompiler.h"
+
+#include <gsl/gsl>
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Babylon::ShaderCache
+{
+    // Compiled shaders are stored as one file per pair of sources in the cache directory, named after a hash
+    // of everything the compiler output depends on: the sources, the compiler options, the target graphics
+    // API, and the versions of the compiler and of the bgfx shader format.
+    uint64_t ComputeKey(std::string_view vertexSource, std::string_view fragmentSource, const ShaderCompiler::Options& options);
+
+    // The binary representation of an entry, also used by shader bundles. Deserialize returns nothing if the
+    // bytes aren't a valid entry for the given key.
+    std::vector<uint8_t> Serialize(uint64_t key, const ShaderCompiler::BgfxShaderInfo& shaderInfo);
+    std::optional<ShaderCompiler::BgfxShaderInfo> Deserialize(uint64_t key, gsl::span<const uint8_t> bytes);
+
+    // Returns nothing if the entry doesn't exist or can't be read.
+    std::optional<ShaderCompiler::BgfxShaderInfo> Read(const std::string& directory, uint64_t key);
+
+    // Failing to write an entry is not an error, the shaders will simply be compiled again next time.
+    void Write(const std::string& directory, uint64_t key, const ShaderCompiler::BgfxShaderInfo& shaderInfo);
+}
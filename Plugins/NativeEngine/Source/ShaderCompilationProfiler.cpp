@@ -0,0 +1,92 @@
+#include "ShaderCompilationProfiler.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace Babylon::ShaderCompilationProfiler
+{
+    namespace
+    {
+        using Profile = Plugins::NativeEngine::ShaderCompilationProfile;
+
+        // Only the slowest programs are kept, along with their names, so that profiling doesn't grow with the
+        // number of programs compiled.
+        constexpr size_t MaxSlowestShaders{10};
+
+        Profile CreateProfile()
+        {
+            Profile profile{};
+            profile.Stages.resize(ShaderCompiler::Statistics::StageCount);
+            for (size_t index = 0; index < profile.Stages.size(); ++index)
+            {
+                profile.Stages[index].Name = ShaderCompiler::Statistics::GetStageName(static_cast<ShaderCompiler::Statistics::Stage>(index));
+            }
+            return profile;
+        }
+
+        std::mutex s_profileMutex{};
+        Profile s_profile{CreateProfile()};
+    }
+
+    std::string GetShaderName(std::string_view vertexSource)
+    {
+        constexpr std::string_view define{"#define SHADER_NAME "};
+
+        const auto start = vertexSource.find(define);
+        if (start == std::string_view::npos)
+        {
+            return {};
+        }
+
+        const auto name = vertexSource.substr(start + define.size());
+        return std::string{name.substr(0, name.find_first_of("\r\n"))};
+    }
+
+    void Record(std::string_view vertexSource, uint64_t key, const ShaderCompiler::Statistics& statistics)
+    {
+        Profile::Shader shader{GetShaderName(vertexSource), key, {}, {statistics.StageDurations.begin(), statistics.StageDurations.end()}};
+        for (const auto duration : statistics.StageDurations)
+        {
+            shader.Duration += duration;
+        }
+
+        std::scoped_lock lock{s_profileMutex};
+
+        ++s_profile.Compilations;
+        s_profile.TotalDuration += shader.Duration;
+
+        for (size_t index = 0; index < ShaderCompiler::Statistics::StageCount; ++index)
+        {
+            auto& stage = s_profile.Stages[index];
+            stage.Count += statistics.StageRuns[index];
+            stage.TotalDuration += statistics.StageDurations[index];
+            stage.MaxDuration = std::max(stage.MaxDuration, statistics.StageDurations[index]);
+        }
+
+        auto& slowest = s_profile.SlowestShaders;
+        if (slowest.size() < MaxSlowestShaders || shader.Duration > slowest.back().Duration)
+        {
+            const auto position = std::upper_bound(slowest.begin(), slowest.end(), shader.Duration, [](auto duration, const Profile::Shader& other) {
+                return duration > other.Duration;
+            });
+            slowest.insert(position, std::move(shader));
+
+            if (slowest.size() > MaxSlowestShaders)
+            {
+                slowest.pop_back();
+            }
+        }
+    }
+
+    Plugins::NativeEngine::ShaderCompilationProfile Get()
+    {
+        std::scoped_lock lock{s_profileMutex};
+        return s_profile;
+    }
+
+    void Reset()
+    {
+        std::scoped_lock lock{s_profileMutex};
+        s_profile = CreateProfile();
+    }
+}
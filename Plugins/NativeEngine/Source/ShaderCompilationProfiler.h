@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Babylon/Plugins/NativeEngine.h>
+#include "ShaderCompiler.h"
+
+#include <string>
+#include <string_view>
+
+namespace Babylon::ShaderCompilationProfiler
+{
+    // The profile is shared by all the NativeEngine instances of the process, which may compile programs on
+    // any thread.
+    void Record(std::string_view vertexSource, uint64_t key, const ShaderCompiler::Statistics& statistics);
+    Plugins::NativeEngine::ShaderCompilationProfile Get();
+    void Reset();
+
+    // The value of the vertex shader's SHADER_NAME define, if any.
+    std::string GetShaderName(std::string_view vertexSource);
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <string_view>
 #include <functional>
 #include <spirv_cross.hpp>
@@ -17,9 +19,85 @@ namespace Babylon
     class ShaderCompiler final
     {
     public:
-        ShaderCompiler();
+        // Identifies the output of the compiler, which cached shaders must match. Must be incremented
+        // by any change to the compiler which changes the shaders it outputs.
+        static constexpr uint32_t Version{3};
+
+        struct Options
+        {
+            // Runs the SPIR-V optimizer (dead code elimination, constant propagation, folding, etc.) on each
+            // stage before cross-compiling it. Requires the optimizer to be available, see
+            // IsSpirvOptimizerAvailable.
+            bool OptimizeSpirv{false};
+        };
+
+        // Whether glslang is built with the SPIR-V optimizer, which requires ENABLE_OPT and SPIRV-Tools.
+        // Constructing a compiler with OptimizeSpirv throws if it isn't.
+        static bool IsSpirvOptimizerAvailable();
+
+        struct Statistics
+        {
+            // The steps of a compilation, in the order in which they run.
+            enum class Stage
+            {
+                // Parsing each shader stage with glslang.
+                Parse,
+                Link,
+                // The traversal collecting the symbols the modifications below operate on.
+                CollectSymbols,
+                // The modifications of ShaderCompilerTraversers, only those used by the platform run.
+                PackUniforms,
+                ChangeUniformTypes,
+                MoveNonSamplerUniformsIntoStruct,
+                AssignLocationsAndNamesToVertexVaryings,
+                SplitSamplersIntoSamplersAndTextures,
+                InvertYDerivativeOperands,
+                // GlslangToSpv, including the SPIR-V optimizer if enabled.
+                GenerateSpirv,
+                // SPIRV-Cross parsing the SPIR-V and generating the platform's shading language.
+                CrossCompile,
+                // Compiling the generated shading language to bytecode, only done on Direct3D.
+                PlatformCompile,
+                CreateBgfxShader,
+                Count
+            };
+
+            static constexpr size_t StageCount{static_cast<size_t>(Stage::Count)};
+
+            static const char* GetStageName(Stage stage);
+
+            // The number of SPIR-V instructions cross-compiled for each stage, after optimization if enabled.
+            uint32_t VertexSpirvInstructions{};
+            uint32_t FragmentSpirvInstructions{};
+
+            // How long each step took in total, and how many times it ran, which is twice for the steps
+            // done once per shader stage and zero for the steps the platform doesn't need.
+            std::array<std::chrono::nanoseconds, StageCount> StageDurations{};
+            std::array<uint8_t, StageCount> StageRuns{};
+        };
+
+        ShaderCompiler()
+            : ShaderCompiler(Options{})
+        {
+        }
+
+        explicit ShaderCompiler(Options options);
         ~ShaderCompiler();
 
+        const Options& GetOptions() const
+        {
+            return m_options;
+        }
+
+        // Where a uniform packed together with others (see ShaderCompilerTraversers::PackUniforms) lives.
+        struct PackedUniform
+        {
+            // The name of the vec4 uniform holding it.
+            std::string Name{};
+            uint8_t Component{};
+            uint8_t Components{};
+        };
+
         struct BgfxShaderInfo
         {
             std::vector<uint8_t> VertexBytes{};
@@ -28,8 +106,15 @@ namespace Babylon
 
             std::vector<uint8_t> FragmentBytes{};
             std::unordered_map<std::string, uint8_t> FragmentUniformStages{};
+
+            // Keyed by the name of the uniform in the original sources.
+            std::unordered_map<std::string, PackedUniform> PackedUniforms{};
         };
 
         BgfxShaderInfo Compile(std::string_view vertexSource, std::string_view fragmentSource);
+        BgfxShaderInfo Compile(std::string_view vertexSource, std::string_view fragmentSource, Statistics& statistics);
+
+    private:
+        Options m_options;
     };
 }
@@ -2,6 +2,7 @@
 #include "ShaderCompiler.h"
 #include <bx/bx.h>
 #include <bgfx/bgfx.h>
+#include <SPIRV/GlslangToSpv.h>
 
 #define BGFX_UNIFORM_FRAGMENTBIT UINT8_C(0x10) // Copy-pasta from bgfx_p.h
 #define BGFX_UNIFORM_SAMPLERBIT UINT8_C(0x20)  // Copy-pasta from bgfx_p.h
@@ -12,8 +13,102 @@ namespace bgfx
     uint16_t attribToId(Attrib::Enum _attr);
 }
 
+namespace Babylon
+{
+    bool ShaderCompiler::IsSpirvOptimizerAvailable()
+    {
+#if ENABLE_OPT
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    const char* ShaderCompiler::Statistics::GetStageName(Stage stage)
+    {
+        switch (stage)
+        {
+        case Stage::Parse:
+            return "Parse";
+        case Stage::Link:
+            return "Link";
+        case Stage::CollectSymbols:
+            return "CollectSymbols";
+        case Stage::PackUniforms:
+            return "PackUniforms";
+        case Stage::ChangeUniformTypes:
+            return "ChangeUniformTypes";
+        case Stage::MoveNonSamplerUniformsIntoStruct:
+            return "MoveNonSamplerUniformsIntoStruct";
+        case Stage::AssignLocationsAndNamesToVertexVaryings:
+            return "AssignLocationsAndNamesToVertexVaryings";
+        case Stage::SplitSamplersIntoSamplersAndTextures:
+            return "SplitSamplersIntoSamplersAndTextures";
+        case Stage::InvertYDerivativeOperands:
+            return "InvertYDerivativeOperands";
+        case Stage::GenerateSpirv:
+            return "GenerateSpirv";
+        case Stage::CrossCompile:
+            return "CrossCompile";
+        case Stage::PlatformCompile:
+            return "PlatformCompile";
+        case Stage::CreateBgfxShader:
+            return "CreateBgfxShader";
+        default:
+            throw std::runtime_error{"Unrecognized compilation stage."};
+        }
+    }
+
+    ShaderCompiler::BgfxShaderInfo ShaderCompiler::Compile(std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        Statistics statistics{};
+        return Compile(vertexSource, fragmentSource, statistics);
+    }
+}
+
 namespace Babylon::ShaderCompilerCommon
 {
+    namespace
+    {
+        uint32_t CountSpirvInstructions(const std::vector<uint32_t>& spirv)
+        {
+            // Instructions follow the five words of the module header. The first word of each instruction
+            // holds its length in words in its upper half.
+            constexpr size_t headerSize{5};
+
+            uint32_t count{0};
+            size_t position{headerSize};
+            while (position < spirv.size())
+            {
+                const uint32_t wordCount{spirv[position] >> 16};
+                if (wordCount == 0)
+                {
+                    throw std::runtime_error{"Invalid SPIR-V instruction."};
+                }
+
+                position += wordCount;
+                ++count;
+            }
+
+            return count;
+        }
+    }
+
+    std::vector<uint32_t> GenerateSpirv(glslang::TProgram& program, EShLanguage stage, const ShaderCompiler::Options& options, ShaderCompiler::Statistics& statistics)
+    {
+        glslang::SpvOptions spvOptions{};
+        spvOptions.disableOptimizer = !options.OptimizeSpirv;
+
+        std::vector<uint32_t> spirv;
+        {
+            StageTimer timer{statistics, ShaderCompiler::Statistics::Stage::GenerateSpirv};
+            glslang::GlslangToSpv(*program.getIntermediate(stage), spirv, &spvOptions);
+        }
+
+        (stage == EShLangVertex ? statistics.VertexSpirvInstructions : statistics.FragmentSpirvInstructions) = CountSpirvInstructions(spirv);
+        return spirv;
+    }
+
     void AppendUniformBuffer(std::vector<uint8_t>& bytes, const NonSamplerUniformsInfo& uniformBuffer, bool isFragment)
     {
         const uint8_t fragmentBit = (isFragment ? BGFX_UNIFORM_FRAGMENTBIT : 0);
@@ -192,10 +287,22 @@ namespace Babylon::ShaderCompilerCommon
             AppendBytes(vertexBytes, vertexShaderInfo.Bytes);
             AppendBytes(vertexBytes, static_cast<uint8_t>(0));
 
-            AppendBytes(vertexBytes, static_cast<uint8_t>(resources.stage_inputs.size()));
-
+            // Instance data is bound by bgfx itself rather than through the vertex layout, so it
+            // must not be declared as a vertex attribute.
+            std::vector<const spirv_cross::Resource*> vertexAttributes{};
             for (const spirv_cross::Resource& stageInput : resources.stage_inputs)
             {
+                if (stageInput.name.compare(0, 6, "i_data") != 0)
+                {
+                    vertexAttributes.push_back(&stageInput);
+                }
+            }
+
+            AppendBytes(vertexBytes, static_cast<uint8_t>(vertexAttributes.size()));
+
+            for (const spirv_cross::Resource* vertexAttribute : vertexAttributes)
+            {
+                const spirv_cross::Resource& stageInput = *vertexAttribute;
                 const uint32_t location = compiler.get_decoration(stageInput.id, spv::DecorationLocation);
                 AppendBytes(vertexBytes, bgfx::attribToId(static_cast<bgfx::Attrib::Enum>(location)));
 
@@ -2,8 +2,10 @@
 
 #include "ShaderCompiler.h"
 
+#include <glslang/Public/ShaderLang.h>
 #include <gsl/gsl>
 #include <spirv_cross.hpp>
+#include <chrono>
 #include <spirv_parser.hpp>
 #include <unordered_map>
 #include <string>
@@ -34,6 +36,36 @@ namespace Babylon::ShaderCompilerCommon
         bytes.insert(bytes.end(), ptr, ptr + stride);
     }
 
+    // Adds the time elapsed between its construction and its destruction to a step of a compilation.
+    class StageTimer final
+    {
+    public:
+        StageTimer(ShaderCompiler::Statistics& statistics, ShaderCompiler::Statistics::Stage stage)
+            : m_statistics{statistics}
+            , m_stage{static_cast<size_t>(stage)}
+            , m_start{std::chrono::steady_clock::now()}
+        {
+        }
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+        ~StageTimer()
+        {
+            m_statistics.StageDurations[m_stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+            ++m_statistics.StageRuns[m_stage];
+        }
+
+    private:
+        ShaderCompiler::Statistics& m_statistics;
+        const size_t m_stage;
+        const std::chrono::steady_clock::time_point m_start;
+    };
+
+    // Generates the SPIR-V of a stage of a linked program, optimizing it if the options say so, and records
+    // its instruction count in the statistics.
+    std::vector<uint32_t> GenerateSpirv(glslang::TProgram& program, EShLanguage stage, const ShaderCompiler::Options& options, ShaderCompiler::Statistics& statistics);
+
     struct NonSamplerUniformsInfo
     {
         struct Uniform
@@ -15,8 +15,10 @@ namespace Babylon
 {
     namespace
     {
-        void AddShader(glslang::TProgram& program, glslang::TShader& shader, std::string_view source)
+        void AddShader(glslang::TProgram& program, glslang::TShader& shader, std::string_view source, ShaderCompiler::Statistics& statistics)
         {
+            ShaderCompilerCommon::StageTimer timer{statistics, ShaderCompiler::Statistics::Stage::Parse};
+
             const std::array<const char*, 1> sources{source.data()};
             shader.setStrings(sources.data(), gsl::narrow_cast<int>(sources.size()));
 
@@ -28,24 +30,30 @@ namespace Babylon
             program.addShader(&shader);
         }
 
-        std::pair<std::unique_ptr<spirv_cross::Parser>, std::unique_ptr<spirv_cross::Compiler>> CompileShader(glslang::TProgram& program, EShLanguage stage, gsl::span<const spirv_cross::HLSLVertexAttributeRemap> attributes, ID3DBlob** blob)
+        std::pair<std::unique_ptr<spirv_cross::Parser>, std::unique_ptr<spirv_cross::Compiler>> CompileShader(glslang::TProgram& program, EShLanguage stage, const ShaderCompiler::Options& options, ShaderCompiler::Statistics& statistics, gsl::span<const spirv_cross::HLSLVertexAttributeRemap> attributes, ID3DBlob** blob)
         {
-            std::vector<uint32_t> spirv;
-            glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
+            std::vector<uint32_t> spirv{ShaderCompilerCommon::GenerateSpirv(program, stage, options, statistics)};
 
-            auto parser = std::make_unique<spirv_cross::Parser>(std::move(spirv));
-            parser->parse();
+            std::unique_ptr<spirv_cross::Parser> parser{};
+            std::unique_ptr<spirv_cross::CompilerHLSL> compiler{};
+            std::string hlsl{};
+            {
+                ShaderCompilerCommon::StageTimer timer{statistics, ShaderCompiler::Statistics::Stage::CrossCompile};
 
-            auto compiler = std::make_unique<spirv_cross::CompilerHLSL>(parser->get_parsed_ir());
+                parser = std::make_unique<spirv_cross::Parser>(std::move(spirv));
+                parser->parse();
 
-            compiler->set_hlsl_options({40, true});
+                compiler = std::make_unique<spirv_cross::CompilerHLSL>(parser->get_parsed_ir());
 
-            for (const auto& attribute : attributes)
-            {
-                compiler->add_vertex_attribute_remap(attribute);
-            }
+                compiler->set_hlsl_options({40, true});
+
+                for (const auto& attribute : attributes)
+                {
+                    compiler->add_vertex_attribute_remap(attribute);
+                }
 
-            std::string hlsl = compiler->compile();
+                hlsl = compiler->compile();
+            }
 
             Microsoft::WRL::ComPtr<ID3DBlob> errorMsgs;
             const char* target = stage == EShLangVertex ? "vs_4_0" : "ps_4_0";
@@ -56,6 +64,7 @@ namespace Babylon
             flags |= D3DCOMPILE_DEBUG;
 #endif
 
+            ShaderCompilerCommon::StageTimer timer{statistics, ShaderCompiler::Statistics::Stage::PlatformCompile};
             if (FAILED(D3DCompile(hlsl.data(), hlsl.size(), nullptr, nullptr, nullptr, "main", target, flags, 0, blob, &errorMsgs)))
             {
                 throw std::runtime_error{static_cast<const char*>(errorMsgs->GetBufferPointer())};
@@ -65,8 +74,14 @@ namespace Babylon
         }
     }
 
-    ShaderCompiler::ShaderCompiler()
+    ShaderCompiler::ShaderCompiler(Options options)
+        : m_options{options}
     {
+        if (m_options.OptimizeSpirv && !IsSpirvOptimizerAvailable())
+        {
+            throw std::runtime_error{"SPIR-V optimization requires glslang to be built with ENABLE_OPT and SPIRV-Tools."};
+        }
+
         glslang::InitializeProcess();
     }
 
@@ -75,32 +90,38 @@ namespace Babylon
         glslang::FinalizeProcess();
     }
 
-    ShaderCompiler::BgfxShaderInfo ShaderCompiler::Compile(std::string_view vertexSource, std::string_view fragmentSource)
+    ShaderCompiler::BgfxShaderInfo ShaderCompiler::Compile(std::string_view vertexSource, std::string_view fragmentSource, Statistics& statistics)
     {
         glslang::TProgram program;
 
         glslang::TShader vertexShader{EShLangVertex};
-        AddShader(program, vertexShader, vertexSource);
+        AddShader(program, vertexShader, vertexSource, statistics);
 
         glslang::TShader fragmentShader{EShLangFragment};
-        AddShader(program, fragmentShader, fragmentSource);
+        AddShader(program, fragmentShader, fragmentSource, statistics);
 
         glslang::SpvVersion spv{};
         spv.spv = 0x10000;
         vertexShader.getIntermediate()->setSpv(spv);
         fragmentShader.getIntermediate()->setSpv(spv);
 
-        if (!program.link(EShMsgDefault))
         {
-            throw std::runtime_error{program.getInfoDebugLog()};
+            ShaderCompilerCommon::StageTimer timer{statistics, Statistics::Stage::Link};
+            if (!program.link(EShMsgDefault))
+            {
+                throw std::runtime_error{program.getInfoDebugLog()};
+            }
         }
 
         ShaderCompilerTraversers::IdGenerator ids{};
-        auto utstScope = ShaderCompilerTraversers::MoveNonSamplerUniformsIntoStruct(program, ids);
+        ShaderCompilerTraversers::Modifications modifications{};
+        modifications.MoveNonSamplerUniformsIntoStruct = true;
+        modifications.SplitSamplersIntoSamplersAndTextures = true;
+        modifications.InvertYDerivativeOperands = true;
         std::unordered_map<std::string, std::string> vertexAttributeRenaming = {};
-        ShaderCompilerTraversers::AssignLocationsAndNamesToVertexVaryings(program, ids, vertexAttributeRenaming);
-        ShaderCompilerTraversers::SplitSamplersIntoSamplersAndTextures(program, ids);
-        ShaderCompilerTraversers::InvertYDerivativeOperands(program);
+        // Uniforms aren't packed since the struct holding them is already laid out with std140 packing.
+        std::unordered_map<std::string, PackedUniform> packedUniforms = {};
+        auto scope = ShaderCompilerTraversers::ModifyProgram(program, ids, modifications, vertexAttributeRenaming, packedUniforms, statistics);
 
         // clang-format off
         static const spirv_cross::HLSLVertexAttributeRemap attributes[] = {
@@ -122,7 +143,7 @@ namespace Babylon
         // clang-format on
 
         Microsoft::WRL::ComPtr<ID3DBlob> vertexBlob;
-        auto [vertexParser, vertexCompiler] = CompileShader(program, EShLangVertex, attributes, &vertexBlob);
+        auto [vertexParser, vertexCompiler] = CompileShader(program, EShLangVertex, m_options, statistics, attributes, &vertexBlob);
         ShaderCompilerCommon::ShaderInfo vertexShaderInfo{
             std::move(vertexParser),
             std::move(vertexCompiler),
@@ -130,13 +151,14 @@ namespace Babylon
             std::move(vertexAttributeRenaming)};
 
         Microsoft::WRL::ComPtr<ID3DBlob> fragmentBlob;
-        auto [fragmentParser, fragmentCompiler] = CompileShader(program, EShLangFragment, {}, &fragmentBlob);
+        auto [fragmentParser, fragmentCompiler] = CompileShader(program, EShLangFragment, m_options, statistics, {}, &fragmentBlob);
         ShaderCompilerCommon::ShaderInfo fragmentShaderInfo{
             std::move(fragmentParser),
             std::move(fragmentCompiler),
             gsl::make_span(static_cast<uint8_t*>(fragmentBlob->GetBufferPointer()), fragmentBlob->GetBufferSize()),
             {}};
 
+        ShaderCompilerCommon::StageTimer timer{statistics, Statistics::Stage::CreateBgfxShader};
         return ShaderCompilerCommon::CreateBgfxShader(std::move(vertexShaderInfo), std::move(fragmentShaderInfo));
     }
 }
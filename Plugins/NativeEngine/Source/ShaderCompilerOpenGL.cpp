@@ -14,8 +14,10 @@ namespace Babylon
 
     namespace
     {
-        void AddShader(glslang::TProgram& program, glslang::TShader& shader, std::string_view source)
+        void AddShader(glslang::TProgram& program, glslang::TShader& shader, std::string_view source, ShaderCompiler::Statistics& statistics)
         {
+            ShaderCompilerCommon::StageTimer timer{statistics, ShaderCompiler::Statistics::Stage::Parse};
+
             const std::array<const char*, 1> sources{source.data()};
             shader.setStrings(sources.data(), gsl::narrow_cast<int>(sources.size()));
 
@@ -27,10 +29,11 @@ namespace Babylon
             program.addShader(&shader);
         }
 
-        std::pair<std::unique_ptr<spirv_cross::Parser>, std::unique_ptr<spirv_cross::Compiler>> CompileShader(glslang::TProgram& program, EShLanguage stage, std::string& glsl)
+        std::pair<std::unique_ptr<spirv_cross::Parser>, std::unique_ptr<spirv_cross::Compiler>> CompileShader(glslang::TProgram& program, EShLanguage stage, const ShaderCompiler::Options& options, ShaderCompiler::Statistics& statistics, std::string& glsl)
         {
-            std::vector<uint32_t> spirv;
-            glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
+            std::vector<uint32_t> spirv{ShaderCompilerCommon::GenerateSpirv(program, stage, options, statistics)};
+
+            ShaderCompilerCommon::StageTimer timer{statistics, ShaderCompiler::Statistics::Stage::CrossCompile};
 
             auto parser = std::make_unique<spirv_cross::Parser>(std::move(spirv));
             parser->parse();
@@ -50,8 +53,14 @@ namespace Babylon
         }
     }
 
-    ShaderCompiler::ShaderCompiler()
+    ShaderCompiler::ShaderCompiler(Options options)
+        : m_options{options}
     {
+        if (m_options.OptimizeSpirv && !IsSpirvOptimizerAvailable())
+        {
+            throw std::runtime_error{"SPIR-V optimization requires glslang to be built with ENABLE_OPT and SPIRV-Tools."};
+        }
+
         glslang::InitializeProcess();
     }
 
@@ -60,39 +69,51 @@ namespace Babylon
         glslang::FinalizeProcess();
     }
 
-    ShaderCompiler::BgfxShaderInfo ShaderCompiler::Compile(std::string_view vertexSource, std::string_view fragmentSource)
+    ShaderCompiler::BgfxShaderInfo ShaderCompiler::Compile(std::string_view vertexSource, std::string_view fragmentSource, Statistics& statistics)
     {
         glslang::TProgram program;
 
         glslang::TShader vertexShader{EShLangVertex};
-        AddShader(program, vertexShader, vertexSource);
+        AddShader(program, vertexShader, vertexSource, statistics);
 
         glslang::TShader fragmentShader{EShLangFragment};
-        AddShader(program, fragmentShader, fragmentSource);
+        AddShader(program, fragmentShader, fragmentSource, statistics);
 
         glslang::SpvVersion spv{};
         spv.spv = 0x10000;
         vertexShader.getIntermediate()->setSpv(spv);
         fragmentShader.getIntermediate()->setSpv(spv);
 
-        if (!program.link(EShMsgDefault))
         {
-            throw std::exception();
+            ShaderCompilerCommon::StageTimer timer{statistics, Statistics::Stage::Link};
+            if (!program.link(EShMsgDefault))
+            {
+                throw std::exception();
+            }
         }
 
         ShaderCompilerTraversers::IdGenerator ids{};
-        auto cutScope = ShaderCompilerTraversers::ChangeUniformTypes(program, ids);
+        ShaderCompilerTraversers::Modifications modifications{};
+        modifications.PackUniforms = true;
+        modifications.ChangeUniformTypes = true;
         std::unordered_map<std::string, std::string> vertexAttributeRenaming = {};
-        ShaderCompilerTraversers::AssignLocationsAndNamesToVertexVaryings(program, ids, vertexAttributeRenaming);
+        std::unordered_map<std::string, PackedUniform> packedUniforms = {};
+        auto scope = ShaderCompilerTraversers::ModifyProgram(program, ids, modifications, vertexAttributeRenaming, packedUniforms, statistics);
 
         std::string vertexGLSL(vertexSource.data(), vertexSource.size());
-        auto [vertexParser, vertexCompiler] = CompileShader(program, EShLangVertex, vertexGLSL);
+        auto [vertexParser, vertexCompiler] = CompileShader(program, EShLangVertex, m_options, statistics, vertexGLSL);
 
         std::string fragmentGLSL(fragmentSource.data(), fragmentSource.size());
-        auto [fragmentParser, fragmentCompiler] = CompileShader(program, EShLangFragment, fragmentGLSL);
+        auto [fragmentParser, fragmentCompiler] = CompileShader(program, EShLangFragment, m_options, statistics, fragmentGLSL);
 
-        return ShaderCompilerCommon::CreateBgfxShader(
-            {std::move(vertexParser), std::move(vertexCompiler), gsl::make_span(reinterpret_cast<uint8_t*>(vertexGLSL.data()), vertexGLSL.size()), std::move(vertexAttributeRenaming)},
-            {std::move(fragmentParser), std::move(fragmentCompiler), gsl::make_span(reinterpret_cast<uint8_t*>(fragmentGLSL.data()), fragmentGLSL.size()), {}});
+        BgfxShaderInfo shaderInfo{};
+        {
+            ShaderCompilerCommon::StageTimer timer{statistics, Statistics::Stage::CreateBgfxShader};
+            shaderInfo = ShaderCompilerCommon::CreateBgfxShader(
+                {std::move(vertexParser), std::move(vertexCompiler), gsl::make_span(reinterpret_cast<uint8_t*>(vertexGLSL.data()), vertexGLSL.size()), std::move(vertexAttributeRenaming)},
+                {std::move(fragmentParser), std::move(fragmentCompiler), gsl::make_span(reinterpret_cast<uint8_t*>(fragmentGLSL.data()), fragmentGLSL.size()), {}});
+        }
+        shaderInfo.PackedUniforms = std::move(packedUniforms);
+        return shaderInfo;
     }
 }
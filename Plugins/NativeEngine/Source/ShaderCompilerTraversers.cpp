@@ -1,4 +1,5 @@
 #include "ShaderCompilerTraversers.h"
+#include "ShaderCompilerCommon.h"
 
 #include <glslang/Include/intermediate.h>
 #include <glslang/MachineIndependent/localintermediate.h>
@@ -9,9 +10,15 @@
 
 #include <arcana/experimental/array.h>
 
+#include <CacheUtils/CacheUtils.h>
+
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 #include <arcana/macros.h>
 
 using namespace glslang;
@@ -25,7 +32,7 @@ namespace Babylon::ShaderCompilerTraversers
     namespace
     {
         /// Helper method to replace symbols in a glslang AST. This operation is done
-        /// by several of the traversers in this file.
+        /// by several of the modifications in this file.
         /// @param nameToReplacement Map from symbol names to the node which should replace that symbol.
         /// @param symbolToParent Vector of symbols to be replaced along with their parents in the AST.
         void makeReplacements(
@@ -82,17 +89,157 @@ namespace Babylon::ShaderCompilerTraversers
             return agg && agg->getOp() == EOpLinkerObjects;
         }
 
-        /// This traverser collects all non-sampler uniforms and creates a new struct
+        /// Helper method to determine whether an operation is a derivative along the Y axis.
+        bool isYDerivative(TOperator op)
+        {
+            return op == EOpDPdy || op == EOpDPdyFine || op == EOpDPdyCoarse;
+        }
+
+        /// An occurrence of a symbol in the AST along with the nodes above it.
+        struct SymbolOccurrence
+        {
+            TIntermSymbol* Symbol{};
+            TIntermNode* Parent{};
+            TIntermNode* Grandparent{};
+            bool IsLinkerObject{};
+        };
+
+        /// Everything the modifications below need to know about one stage of a program.
+        /// This is collected by a single traversal of the stage's AST, after which each
+        /// modification works from these lists rather than traversing the AST again.
+        /// Occurrences are listed in the order a traversal would visit them. Modifications
+        /// which move symbols to a different place in the AST must update the occurrences
+        /// to match so that the modifications performed after them remain correct.
+        struct StageSymbols
+        {
+            std::vector<SymbolOccurrence> NonSamplerUniforms{};
+            std::vector<SymbolOccurrence> Samplers{};
+            std::vector<SymbolOccurrence> VaryingsIn{};
+
+            /// Outermost Y derivative operations; derivatives nested within their operands
+            /// are not listed.
+            std::vector<TIntermUnary*> YDerivatives{};
+        };
+
+        struct ProgramSymbols
+        {
+            StageSymbols Vertex{};
+            StageSymbols Fragment{};
+        };
+
+        /// This traverser collects the StageSymbols of a stage.
+        class SymbolCollectionTraverser final : private TIntermTraverser
+        {
+        public:
+            static StageSymbols Traverse(TIntermediate* intermediate)
+            {
+                SymbolCollectionTraverser traverser{};
+                intermediate->getTreeRoot()->traverse(&traverser);
+                return std::move(traverser.m_symbols);
+            }
+
+            static ProgramSymbols Traverse(TProgram& program)
+            {
+                return {Traverse(program.getIntermediate(EShLangVertex)), Traverse(program.getIntermediate(EShLangFragment))};
+            }
+
+        private:
+            virtual void visitSymbol(TIntermSymbol* symbol) override
+            {
+                const auto& type = symbol->getType();
+
+                std::vector<SymbolOccurrence>* occurrences{};
+                if (type.getQualifier().storage == EvqUniform && type.getBasicType() == EbtSampler)
+                {
+                    occurrences = &m_symbols.Samplers;
+                }
+                else if (type.getQualifier().isUniformOrBuffer() && type.getBasicType() != EbtSampler)
+                {
+                    occurrences = &m_symbols.NonSamplerUniforms;
+                }
+                else if (type.getQualifier().storage == EvqVaryingIn)
+                {
+                    occurrences = &m_symbols.VaryingsIn;
+                }
+
+                if (occurrences)
+                {
+                    auto* grandparent = this->path.size() > 1 ? this->path[this->path.size() - 2] : nullptr;
+                    occurrences->push_back({symbol, this->getParentNode(), grandparent, isLinkerObject(this->path)});
+                }
+            }
+
+            virtual bool visitUnary(TVisit visit, TIntermUnary* unary) override
+            {
+                if (visit == EvPreVisit && isYDerivative(unary->getOp()))
+                {
+                    const auto nested = std::any_of(this->path.begin(), this->path.end(), [](TIntermNode* node) {
+                        auto* ancestor = node->getAsUnaryNode();
+                        return ancestor && isYDerivative(ancestor->getOp());
+                    });
+
+                    if (!nested)
+                    {
+                        m_symbols.YDerivatives.push_back(unary);
+                    }
+                }
+
+                // Keep going regardless in order to collect the symbols in the operand.
+                return true;
+            }
+
+            StageSymbols m_symbols{};
+        };
+
+        /// This traverser finds where a symbol ended up within a subtree after that subtree
+        /// was inserted above it.
+        class SymbolFinderTraverser final : private TIntermTraverser
+        {
+        public:
+            static void Traverse(TIntermNode* root, SymbolOccurrence& occurrence)
+            {
+                SymbolFinderTraverser traverser{occurrence.Symbol};
+                root->traverse(&traverser);
+                if (!traverser.m_parent)
+                {
+                    throw std::runtime_error{"Cannot find symbol: symbol missing from its replacement"};
+                }
+
+                occurrence.Parent = traverser.m_parent;
+                occurrence.Grandparent = traverser.m_grandparent;
+            }
+
+        private:
+            SymbolFinderTraverser(TIntermSymbol* symbol)
+                : m_symbol{symbol}
+            {
+            }
+
+            virtual void visitSymbol(TIntermSymbol* symbol) override
+            {
+                if (symbol == m_symbol && !m_parent)
+                {
+                    m_parent = this->getParentNode();
+                    m_grandparent = this->path.size() > 1 ? this->path[this->path.size() - 2] : nullptr;
+                }
+            }
+
+            TIntermSymbol* m_symbol{};
+            TIntermNode* m_parent{};
+            TIntermNode* m_grandparent{};
+        };
+
+        /// This modification collects all non-sampler uniforms and creates a new struct
         /// called "Frame" to contain them. This is necessary to correctly transpile
         /// for DirectX and Metal.
-        class NonSamplerUniformToStructTraverser final : private TIntermTraverser
+        class NonSamplerUniformToStructModification final
         {
         public:
-            static ScopeT Traverse(TProgram& program, IdGenerator& ids)
+            static ScopeT Apply(TProgram& program, ProgramSymbols& symbols, IdGenerator& ids)
             {
                 auto* scope = new AllocationsScope();
-                Traverse(program.getIntermediate(EShLangVertex), ids, *scope);
-                Traverse(program.getIntermediate(EShLangFragment), ids, *scope);
+                Apply(program.getIntermediate(EShLangVertex), symbols.Vertex, ids, *scope);
+                Apply(program.getIntermediate(EShLangFragment), symbols.Fragment, ids, *scope);
                 return std::unique_ptr<AllocationsScopeBase>(scope);
             }
 
@@ -103,37 +250,32 @@ namespace Babylon::ShaderCompilerTraversers
             class AllocationsScope : AllocationsScopeBase
             {
             private:
-                friend NonSamplerUniformToStructTraverser;
+                friend NonSamplerUniformToStructModification;
                 std::vector<std::unique_ptr<TType>> Types{};
                 std::vector<std::unique_ptr<TTypeList>> TypeLists{};
                 std::vector<std::unique_ptr<TArraySizes>> ArraySizes{};
             };
 
-            virtual void visitSymbol(TIntermSymbol* symbol) override
+            static void Apply(TIntermediate* intermediate, StageSymbols& symbols, IdGenerator& ids, AllocationsScope& scope)
             {
-                // Collect all non-sampler uniforms and add the to the list of elements to process.
-                if (symbol->getType().getQualifier().isUniformOrBuffer() && symbol->getType().getBasicType() != EbtSampler)
+                // Linker objects are treated differently by this modification because unlike ordinary
+                // symbols which should simply be replaced with their struct members, the linker
+                // section of the AST must be fundamentally changed to represent the fact that the
+                // new struct exists and that many things that were previously independent linker
+                // objects are now just a part of the new struct.
+                std::map<std::string, TIntermSymbol*> uniformNameToSymbol{};
+                std::vector<std::pair<TIntermSymbol*, TIntermNode*>> symbolsToParents{};
+                for (const auto& occurrence : symbols.NonSamplerUniforms)
                 {
-                    // Linker objects are treated differently by this traverser because unlike ordinary
-                    // symbols which should simply be replaced with their struct members, the linker
-                    // section of the AST must be fundamentally changed to represent the fact that the
-                    // new struct exists and that many things that were previously independent linker
-                    // objects are now just a part of the new struct.
-                    if (isLinkerObject(this->path))
+                    if (occurrence.IsLinkerObject)
                     {
-                        m_uniformNameToSymbol[symbol->getName().c_str()] = symbol;
+                        uniformNameToSymbol[occurrence.Symbol->getName().c_str()] = occurrence.Symbol;
                     }
                     else
                     {
-                        m_symbolsToParents.emplace_back(symbol, this->getParentNode());
+                        symbolsToParents.emplace_back(occurrence.Symbol, occurrence.Parent);
                     }
                 }
-            }
-
-            static void Traverse(TIntermediate* intermediate, IdGenerator& ids, AllocationsScope& scope)
-            {
-                NonSamplerUniformToStructTraverser traverser{};
-                intermediate->getTreeRoot()->traverse(&traverser);
 
                 std::map<std::string, TIntermTyped*> originalNameToReplacement{};
 
@@ -152,7 +294,7 @@ namespace Babylon::ShaderCompilerTraversers
                 auto* structMembers = scope.TypeLists.back().get();
 
                 // Create all the types for the members of the new struct.
-                for (const auto& [name, symbol] : traverser.m_uniformNameToSymbol)
+                for (const auto& [name, symbol] : uniformNameToSymbol)
                 {
                     const auto& type = symbol->getType();
                     if (type.isMatrix())
@@ -234,8 +376,8 @@ namespace Babylon::ShaderCompilerTraversers
                     auto* symbol = sequence[idx]->getAsSymbolNode();
                     if (symbol)
                     {
-                        auto found = traverser.m_uniformNameToSymbol.find(symbol->getName().c_str());
-                        if (found != traverser.m_uniformNameToSymbol.end())
+                        auto found = uniformNameToSymbol.find(symbol->getName().c_str());
+                        if (found != uniformNameToSymbol.end())
                         {
                             RemoveAllTreeNodes(symbol);
                             sequence.erase(sequence.begin() + idx);
@@ -246,23 +388,207 @@ namespace Babylon::ShaderCompilerTraversers
 
                 // Replace all remaining occurrances of the affected symbols with the new
                 // operations retrieving them from the struct.
-                makeReplacements(originalNameToReplacement, traverser.m_symbolsToParents);
+                makeReplacements(originalNameToReplacement, symbolsToParents);
+
+                // The uniforms no longer exist.
+                symbols.NonSamplerUniforms.clear();
             }
+        };
 
-            std::map<std::string, TIntermSymbol*> m_uniformNameToSymbol{};
-            std::vector<std::pair<TIntermSymbol*, TIntermNode*>> m_symbolsToParents{};
+        /// Packs float, vec2, and vec3 uniforms together into shared vec4 uniforms, so that
+        /// platforms which otherwise give each of them a whole vec4 (see UniformTypeChange)
+        /// don't upload several times more uniform data than the shaders actually use. This
+        /// is used for OpenGL and Metal.
+        class UniformPackingModification final
+        {
+        public:
+            static void Apply(TProgram& program, ProgramSymbols& symbols, IdGenerator& ids, std::unordered_map<std::string, ShaderCompiler::PackedUniform>& packedUniforms)
+            {
+                // Both stages must agree on where each uniform lives, since a uniform used by both
+                // stages is a single uniform as far as bgfx is concerned; so the layout is decided
+                // once for the program as a whole.
+                std::map<std::string, int> nameToSize{};
+                for (const auto* stage : {&symbols.Vertex, &symbols.Fragment})
+                {
+                    for (const auto& occurrence : stage->NonSamplerUniforms)
+                    {
+                        const auto& type = occurrence.Symbol->getType();
+                        if (occurrence.IsLinkerObject && IsPackable(type))
+                        {
+                            nameToSize[occurrence.Symbol->getName().c_str()] = type.getVectorSize();
+                        }
+                    }
+                }
+
+                // Largest first, each uniform goes into the first vector it fits in.
+                std::vector<std::vector<std::pair<std::string, int>>> vectors{};
+                std::vector<int> vectorSizes{};
+                for (int size = 3; size > 0; --size)
+                {
+                    for (const auto& [name, uniformSize] : nameToSize)
+                    {
+                        if (uniformSize != size)
+                        {
+                            continue;
+                        }
+
+                        size_t index = 0;
+                        while (index < vectors.size() && vectorSizes[index] + size > 4)
+                        {
+                            ++index;
+                        }
+
+                        if (index == vectors.size())
+                        {
+                            vectors.emplace_back();
+                            vectorSizes.push_back(0);
+                        }
+
+                        vectors[index].emplace_back(name, size);
+                        vectorSizes[index] += size;
+                    }
+                }
+
+                // A uniform alone in its vector gains nothing from being packed, so it is left alone.
+                for (const auto& members : vectors)
+                {
+                    if (members.size() > 1)
+                    {
+                        const std::string packedName{GetPackedName(members)};
+                        uint8_t component = 0;
+                        for (const auto& [name, size] : members)
+                        {
+                            packedUniforms[name] = {packedName, component, static_cast<uint8_t>(size)};
+                            component += static_cast<uint8_t>(size);
+                        }
+                    }
+                }
+
+                Apply(program.getIntermediate(EShLangVertex), symbols.Vertex, ids, packedUniforms);
+                Apply(program.getIntermediate(EShLangFragment), symbols.Fragment, ids, packedUniforms);
+            }
+
+        private:
+            // bgfx shares uniforms by name between all programs, so the name of a packed uniform identifies
+            // its layout: programs share a packed uniform only if it packs the same uniforms the same way.
+            static std::string GetPackedName(const std::vector<std::pair<std::string, int>>& members)
+            {
+                uint64_t hash{CacheUtils::Fnv1aOffsetBasis};
+                for (const auto& [name, size] : members)
+                {
+                    // The names are null terminated to keep the boundaries between them unambiguous.
+                    hash = CacheUtils::Fnv1a(name.c_str(), name.size() + 1, hash);
+                    hash = CacheUtils::Fnv1a(&size, sizeof(size), hash);
+                }
+
+                char packedName[32];
+                std::snprintf(packedName, sizeof(packedName), "packedUniforms%016llx", static_cast<unsigned long long>(hash));
+                return packedName;
+            }
+
+            static bool IsPackable(const TType& type)
+            {
+                return type.getQualifier().storage == EvqUniform && type.getBasicType() == EbtFloat && !type.isArray() && !type.isMatrix() && type.getVectorSize() < 4;
+            }
+
+            static void Apply(TIntermediate* intermediate, StageSymbols& symbols, IdGenerator& ids, const std::unordered_map<std::string, ShaderCompiler::PackedUniform>& packedUniforms)
+            {
+                TSourceLoc loc{};
+                loc.init();
+
+                std::map<std::string, TIntermSymbol*> nameToPackedSymbol{};
+                const auto getPackedSymbol = [&](const ShaderCompiler::PackedUniform& packedUniform, const TType& memberType) {
+                    auto& packedSymbol = nameToPackedSymbol[packedUniform.Name];
+                    if (!packedSymbol)
+                    {
+                        TPublicType publicType{};
+                        publicType.qualifier = memberType.getQualifier();
+                        publicType.qualifier.precision = EpqHigh;
+                        publicType.basicType = EbtFloat;
+                        publicType.setVector(4);
+
+                        TType packedType{publicType};
+                        packedSymbol = intermediate->addSymbol(TIntermSymbol{ids.Next(), packedUniform.Name.c_str(), packedType});
+                    }
+                    return packedSymbol;
+                };
+
+                // Every other occurrence of a packed uniform is replaced with an access to the
+                // components of the vector holding it.
+                std::vector<SymbolOccurrence> occurrences{};
+                for (const auto& occurrence : symbols.NonSamplerUniforms)
+                {
+                    const std::string name{occurrence.Symbol->getName().c_str()};
+                    const auto found = packedUniforms.find(name);
+                    if (found == packedUniforms.end())
+                    {
+                        occurrences.push_back(occurrence);
+                        continue;
+                    }
+
+                    auto* packedSymbol = getPackedSymbol(found->second, occurrence.Symbol->getType());
+                    if (occurrence.IsLinkerObject)
+                    {
+                        continue;
+                    }
+
+                    TIntermTyped* access;
+                    if (found->second.Components == 1)
+                    {
+                        access = intermediate->addIndex(EOpIndexDirect, packedSymbol, intermediate->addConstantUnion(static_cast<int>(found->second.Component), loc), loc);
+                    }
+                    else
+                    {
+                        TSwizzleSelectors<TVectorSelector> selectors{};
+                        for (int index = 0; index < found->second.Components; ++index)
+                        {
+                            selectors.push_back(found->second.Component + index);
+                        }
+                        access = intermediate->addIndex(EOpVectorSwizzle, packedSymbol, intermediate->addSwizzle(selectors, loc), loc);
+                    }
+
+                    TType accessType{EbtFloat, EvqTemporary, found->second.Components};
+                    accessType.getQualifier().precision = EpqHigh;
+                    access->setType(accessType);
+
+                    makeReplacements({{name, access}}, {{occurrence.Symbol, occurrence.Parent}});
+                    occurrences.push_back({packedSymbol, access, occurrence.Parent, false});
+                }
+
+                // The packed uniforms take the place of their members among the linker objects.
+                auto* linkerObjectAggregate = intermediate->getTreeRoot()->getAsAggregate()->getSequence().back()->getAsAggregate();
+                assert(linkerObjectAggregate->getOp() == EOpLinkerObjects);
+                auto& sequence = linkerObjectAggregate->getSequence();
+                for (int idx = gsl::narrow_cast<int>(sequence.size()) - 1; idx >= 0; --idx)
+                {
+                    auto* symbol = sequence[idx]->getAsSymbolNode();
+                    if (symbol && packedUniforms.find(symbol->getName().c_str()) != packedUniforms.end())
+                    {
+                        RemoveAllTreeNodes(symbol);
+                        sequence.erase(sequence.begin() + idx);
+                    }
+                }
+
+                for (const auto& [name, packedSymbol] : nameToPackedSymbol)
+                {
+                    sequence.insert(sequence.begin(), packedSymbol);
+                    occurrences.push_back({packedSymbol, linkerObjectAggregate, intermediate->getTreeRoot(), true});
+                }
+
+                symbols.NonSamplerUniforms = std::move(occurrences);
+            }
         };
 
         /// Changes the types of all float, vec2, and vec3 uniforms to vec4. This is required
         /// for OpenGL and Metal.
-        class UniformTypeChangeTraverser final : private TIntermTraverser
+        class UniformTypeChangeModification final
         {
         public:
-            static ScopeT Traverse(TProgram& program, IdGenerator& ids)
+            static ScopeT Apply(TProgram& program, ProgramSymbols& symbols)
             {
                 auto* scope = new AllocationsScope();
-                Traverse(program.getIntermediate(EShLangVertex), ids, *scope);
-                Traverse(program.getIntermediate(EShLangFragment), ids, *scope);
+                Apply(program.getIntermediate(EShLangVertex), symbols.Vertex, *scope);
+                Apply(program.getIntermediate(EShLangFragment), symbols.Fragment, *scope);
                 return std::unique_ptr<AllocationsScopeBase>(scope);
             }
 
@@ -270,21 +596,23 @@ namespace Babylon::ShaderCompilerTraversers
             class AllocationsScope : AllocationsScopeBase
             {
             private:
-                friend UniformTypeChangeTraverser;
+                friend UniformTypeChangeModification;
                 std::vector<std::unique_ptr<TArraySizes>> ArraySizes{};
             };
 
-            UniformTypeChangeTraverser(TIntermediate* intermediate, AllocationsScope& scope)
-                : m_intermediate{intermediate}
-                , m_scope{scope}
+            static void Apply(TIntermediate* intermediate, StageSymbols& symbols, AllocationsScope& scope)
             {
+                for (auto& occurrence : symbols.NonSamplerUniforms)
+                {
+                    Apply(intermediate, occurrence, scope);
+                }
             }
 
-            /// Because no accumulation or cross-correlation is necessary for this change
-            /// (i.e. each operation acts only on a single symbol), we do all the work inside
-            /// the traverser itself.
-            virtual void visitSymbol(TIntermSymbol* symbol) override
+            /// No accumulation or cross-correlation is necessary for this change (i.e. each
+            /// operation acts only on a single symbol), so occurrences are changed one by one.
+            static void Apply(TIntermediate* intermediate, SymbolOccurrence& occurrence, AllocationsScope& scope)
             {
+                auto* symbol = occurrence.Symbol;
                 auto& type = symbol->getType();
 
                 // We only care about uniforms that are neither samplers nor matrices.
@@ -304,8 +632,8 @@ namespace Babylon::ShaderCompilerTraversers
 
                     if (type.getArraySizes())
                     {
-                        m_scope.ArraySizes.emplace_back(std::make_unique<TArraySizes>());
-                        publicType.arraySizes = m_scope.ArraySizes.back().get();
+                        scope.ArraySizes.emplace_back(std::make_unique<TArraySizes>());
+                        publicType.arraySizes = scope.ArraySizes.back().get();
                         *publicType.arraySizes = *type.getArraySizes();
                     }
                     else
@@ -353,7 +681,7 @@ namespace Babylon::ShaderCompilerTraversers
 
                     // Because we modified the original symbol, we don't need to do anything to linker objects.
                     // The only further work we need to do is to handle reshaping.
-                    if (!isLinkerObject(this->path))
+                    if (!occurrence.IsLinkerObject)
                     {
                         // Reshaping (or, perhaps more commonly, swizzling) must be explicitly done on certain
                         // platforms to resolve discrepancies between the size of the data provided by the new
@@ -361,7 +689,7 @@ namespace Babylon::ShaderCompilerTraversers
                         // Fortunately, the glslang intermediate representation makes it reasonably simple to
                         // create a shape conversion operation -- unless the uniform is an array, in which case
                         // it's slightly more complicated.
-                        auto* parent = this->getParentNode();
+                        auto* parent = occurrence.Parent;
                         if (symbol->isArray())
                         {
                             // Converting the shape of an element retrieved from an array is similar to converting
@@ -383,11 +711,15 @@ namespace Babylon::ShaderCompilerTraversers
                                 auto* binType = newType.clone();
                                 binType->clearArraySizes();
                                 binary->setType(*binType);
-                                auto shapeConversion = m_intermediate->addShapeConversion(*oldType, binary);
+                                auto shapeConversion = intermediate->addShapeConversion(*oldType, binary);
+
+                                assert(occurrence.Grandparent);
+                                injectShapeConversion(binary, occurrence.Grandparent, shapeConversion);
 
-                                assert(this->path.size() > 1);
-                                auto* grandparent = this->path[this->path.size() - 2];
-                                injectShapeConversion(binary, grandparent, shapeConversion);
+                                if (shapeConversion != binary)
+                                {
+                                    SymbolFinderTraverser::Traverse(shapeConversion, occurrence);
+                                }
                             }
                             else
                             {
@@ -396,57 +728,35 @@ namespace Babylon::ShaderCompilerTraversers
                         }
                         else
                         {
-                            auto shapeConversion = m_intermediate->addShapeConversion(*oldType, symbol);
+                            auto shapeConversion = intermediate->addShapeConversion(*oldType, symbol);
                             injectShapeConversion(symbol, parent, shapeConversion);
+
+                            // The symbol now lives within the shape conversion, which matters to
+                            // modifications of uniforms performed after this one.
+                            if (shapeConversion != symbol)
+                            {
+                                SymbolFinderTraverser::Traverse(shapeConversion, occurrence);
+                            }
                         }
                     }
 
                     delete oldType;
                 }
             }
-
-            static void Traverse(TIntermediate* intermediate, IdGenerator&, AllocationsScope& scope)
-            {
-                UniformTypeChangeTraverser traverser{intermediate, scope};
-                intermediate->getTreeRoot()->traverse(&traverser);
-            }
-
-            TIntermediate* m_intermediate{};
-            AllocationsScope& m_scope;
         };
 
-        /// This traverser modifies all vertex attributes (position, UV, etc.) to conform to
+        /// This modification changes all vertex attributes (position, UV, etc.) to conform to
         /// bgfx's expectations regarding name and location. It is currently required for
         /// DirectX, OpenGL, and Metal.
-        class VertexVaryingInTraverser final : private TIntermTraverser
+        class VertexVaryingInModification final
         {
         public:
-            static void Traverse(TProgram& program, IdGenerator& ids, std::unordered_map<std::string, std::string>& replacementToOriginalName)
+            static void Apply(TProgram& program, ProgramSymbols& symbols, IdGenerator& ids, std::unordered_map<std::string, std::string>& replacementToOriginalName)
             {
-                Traverse(program.getIntermediate(EShLangVertex), ids, replacementToOriginalName);
+                Apply(program.getIntermediate(EShLangVertex), symbols.Vertex, ids, replacementToOriginalName);
             }
 
         private:
-            virtual void visitSymbol(TIntermSymbol* symbol) override
-            {
-                // Collect all vertex attributes, described by glslang as "varyings."
-                if (symbol->getType().getQualifier().storage == EvqVaryingIn)
-                {
-                    // Limit this cache to linker objects because we know they will comprehensively
-                    // include varyings and will list each only once, making this map as predictable
-                    // as possible.
-                    if (isLinkerObject(this->path))
-                    {
-                        m_varyingNameToSymbol[symbol->getName().c_str()] = symbol;
-                    }
-
-                    // Because the symbol replacement for varyings is just a new symbol with the
-                    // correct parameters, we can just do the linker object replacement alongside
-                    // the other replacements, so we add the occurrence here regardless of whether
-                    // we're in a linker object.
-                    m_symbolsToParents.emplace_back(symbol, this->getParentNode());
-                }
-            }
 
 #if __APPLE__ || APIOpenGL
             // This table is a copy of the table bgfx uses for vertex attribute -> shader symbol association.
@@ -475,8 +785,39 @@ namespace Babylon::ShaderCompilerTraversers
             BX_STATIC_ASSERT(bgfx::Attrib::Count == BX_COUNTOF(s_attribName));
 #endif
 
+            /// Babylon.js passes the world matrix of each instance through the world0 to world3
+            /// attributes. These are mapped to bgfx's instance data, which bgfx binds by the
+            /// names i_data0 to i_data3 on OpenGL and Metal and to the semantics TEXCOORD7 down
+            /// to TEXCOORD4 on DirectX. The locations used for DirectX are therefore reserved
+            /// in shaders using instancing.
+            constexpr static const char* s_instanceAttributeNames[] = {"world0", "world1", "world2", "world3"};
+            constexpr static const char* s_instanceDataNames[] = {"i_data0", "i_data1", "i_data2", "i_data3"};
+
+            static int GetInstanceDataIndex(const char* name)
+            {
+                for (int index = 0; index < static_cast<int>(BX_COUNTOF(s_instanceAttributeNames)); ++index)
+                {
+                    if (std::strcmp(name, s_instanceAttributeNames[index]) == 0)
+                    {
+                        return index;
+                    }
+                }
+                return -1;
+            }
+
+            void ThrowTooManyAttributes() const
+            {
+                throw std::runtime_error("Cannot support more than " + std::to_string(m_genericAttributesLimit) + " vertex attributes.");
+            }
+
             std::pair<unsigned int, const char*> GetVaryingLocationAndNewNameForName(const char* name)
             {
+                const int instanceDataIndex = GetInstanceDataIndex(name);
+                if (instanceDataIndex >= 0)
+                {
+                    return {static_cast<unsigned int>(bgfx::Attrib::TexCoord7) - instanceDataIndex, s_instanceDataNames[instanceDataIndex]};
+                }
+
 #if __APPLE__ || APIOpenGL
                 // For OpenGL and Metal platforms, we have an issue where we have a hard limit on the number shader attributes supported.
                 // To work around this issue, instead of mapping our attributes to the most similar bgfx::attribute, instead replace
@@ -484,8 +825,8 @@ namespace Babylon::ShaderCompilerTraversers
                 // This will cause our shader to have nonsensical naming, but will allow us to efficiently "pack" the attributes.
                 UNUSED(name);
                 m_genericAttributesRunningCount++;
-                if (m_genericAttributesRunningCount >= static_cast<unsigned int>(bgfx::Attrib::Count))
-                    throw std::runtime_error("Cannot support more than 18 vertex attributes.");
+                if (m_genericAttributesRunningCount >= m_genericAttributesLimit)
+                    ThrowTooManyAttributes();
 
                 return {static_cast<unsigned int>(m_genericAttributesRunningCount-1), s_attribName[static_cast<unsigned int>(m_genericAttributesRunningCount-1)]};
 #else
@@ -506,16 +847,32 @@ namespace Babylon::ShaderCompilerTraversers
                 IF_NAME_RETURN_ATTRIB("matricesWeights", bgfx::Attrib::Weight, "a_weight")
 #undef IF_NAME_RETURN_ATTRIB
                 const unsigned int attributeLocation = FIRST_GENERIC_ATTRIBUTE_LOCATION + m_genericAttributesRunningCount++;
-                if (attributeLocation >= static_cast<unsigned int>(bgfx::Attrib::Count))
-                    throw std::runtime_error("Cannot support more than 18 vertex attributes.");
+                if (attributeLocation >= m_genericAttributesLimit)
+                    ThrowTooManyAttributes();
                 return {attributeLocation, name};
 #endif
             }
 
-            static void Traverse(TIntermediate* intermediate, IdGenerator& ids, std::unordered_map<std::string, std::string>& replacementToOriginalName)
+            static void Apply(TIntermediate* intermediate, StageSymbols& symbols, IdGenerator& ids, std::unordered_map<std::string, std::string>& replacementToOriginalName)
             {
-                VertexVaryingInTraverser traverser{};
-                intermediate->getTreeRoot()->traverse(&traverser);
+                // Collect all vertex attributes, described by glslang as "varyings."
+                VertexVaryingInModification modification{};
+                for (const auto& occurrence : symbols.VaryingsIn)
+                {
+                    // Limit this cache to linker objects because we know they will comprehensively
+                    // include varyings and will list each only once, making this map as predictable
+                    // as possible.
+                    if (occurrence.IsLinkerObject)
+                    {
+                        modification.m_varyingNameToSymbol[occurrence.Symbol->getName().c_str()] = occurrence.Symbol;
+                    }
+
+                    // Because the symbol replacement for varyings is just a new symbol with the
+                    // correct parameters, we can just do the linker object replacement alongside
+                    // the other replacements, so we add the occurrence here regardless of whether
+                    // we're in a linker object.
+                    modification.m_symbolsToParents.emplace_back(occurrence.Symbol, occurrence.Parent);
+                }
 
                 std::map<std::string, TIntermTyped*> originalNameToReplacement{};
 
@@ -525,26 +882,35 @@ namespace Babylon::ShaderCompilerTraversers
                 TPublicType publicType{};
                 publicType.qualifier.clearLayout();
 
+                for (const auto& [name, symbol] : modification.m_varyingNameToSymbol)
+                {
+                    if (GetInstanceDataIndex(name.c_str()) >= 0)
+                    {
+                        modification.m_genericAttributesLimit = static_cast<unsigned int>(bgfx::Attrib::TexCoord7) + 1 - BX_COUNTOF(s_instanceAttributeNames);
+                        break;
+                    }
+                }
+
 #if !(__APPLE__ || APIOpenGL)
                 // UVs are effectively a special kind of generic attribute since they both use
                 // are implemented using texture coordinates, so we preprocess to pre-count the
                 // number of UV coordinate variables to prevent collisions.
-                for (const auto& [name, symbol] : traverser.m_varyingNameToSymbol)
+                for (const auto& [name, symbol] : modification.m_varyingNameToSymbol)
                 {
                     if (name.size() >= 2 && name[0] == 'u' && name[1] == 'v')
                     {
-                        traverser.m_genericAttributesRunningCount++;
+                        modification.m_genericAttributesRunningCount++;
                     }
                 }
 #endif
                 // Create the new symbols with which to replace all of the original varying
                 // symbols. The primary purpose of these new symbols is to contain the required
                 // name and location.
-                for (const auto& [name, symbol] : traverser.m_varyingNameToSymbol)
+                for (const auto& [name, symbol] : modification.m_varyingNameToSymbol)
                 {
                     const auto& type = symbol->getType();
                     publicType.qualifier = type.getQualifier();
-                    auto [location, newName] = traverser.GetVaryingLocationAndNewNameForName(name.c_str());
+                    auto [location, newName] = modification.GetVaryingLocationAndNewNameForName(name.c_str());
                     // It may not be necessary to specify this on certain platforms (like OpenGL),
                     // which might simplify the handling of scenarios where we currently run out
                     // of attribute locations.
@@ -566,12 +932,16 @@ namespace Babylon::ShaderCompilerTraversers
                     replacementToOriginalName[newName] = name;
                 }
 
-                makeReplacements(originalNameToReplacement, traverser.m_symbolsToParents);
+                makeReplacements(originalNameToReplacement, modification.m_symbolsToParents);
+
+                // The original varyings no longer exist.
+                symbols.VaryingsIn.clear();
             }
 # if !(__APPLE__ || APIOpenGL)
             const unsigned int FIRST_GENERIC_ATTRIBUTE_LOCATION{10};
 # endif
             unsigned int m_genericAttributesRunningCount{0};
+            unsigned int m_genericAttributesLimit{static_cast<unsigned int>(bgfx::Attrib::Count)};
             std::map<std::string, TIntermSymbol*> m_varyingNameToSymbol{};
             std::vector<std::pair<TIntermSymbol*, TIntermNode*>> m_symbolsToParents{};
         };
@@ -580,39 +950,35 @@ namespace Babylon::ShaderCompilerTraversers
         /// Split sampler symbols into separate sampler and texture symbols. This is
         /// required for DirectX, OpenGL, and Metal.
         /// </summary>
-        class SamplerSplitterTraverser final : TIntermTraverser
+        class SamplerSplitterModification final
         {
         public:
-            void visitSymbol(TIntermSymbol* symbol) override
+            static void Apply(TProgram& program, ProgramSymbols& symbols, IdGenerator& ids)
             {
-                if (symbol->getType().getQualifier().storage == EvqUniform && symbol->getType().getBasicType() == EbtSampler)
+                Apply(program.getIntermediate(EShLangVertex), symbols.Vertex, ids);
+                Apply(program.getIntermediate(EShLangFragment), symbols.Fragment, ids);
+            }
+
+        private:
+            static void Apply(TIntermediate* intermediate, StageSymbols& symbols, IdGenerator& ids)
+            {
+                // Collect all sampler uniform symbols into the relevant caches for
+                // later proccessing. Note that we treat linker object replacement
+                // differently in this modification, so we don't add linker object
+                // symbols to the symbolsToParents cache.
+                std::map<std::string, TIntermSymbol*> samplerNameToSymbol{};
+                std::vector<std::pair<TIntermSymbol*, TIntermNode*>> symbolsToParents{};
+                for (const auto& occurrence : symbols.Samplers)
                 {
-                    // Collect all sampler uniform symbols into the relevant caches
-                    // later proccessing. Note that we treat linker object replacement
-                    // differently in this traverser, so we don't add linker object symbols
-                    // to the m_symbolsToParents cache.
-                    if (isLinkerObject(this->path))
+                    if (occurrence.IsLinkerObject)
                     {
-                        m_samplerNameToSymbol[symbol->getName().c_str()] = symbol;
+                        samplerNameToSymbol[occurrence.Symbol->getName().c_str()] = occurrence.Symbol;
                     }
                     else
                     {
-                        m_symbolsToParents.emplace_back(symbol, this->getParentNode());
+                        symbolsToParents.emplace_back(occurrence.Symbol, occurrence.Parent);
                     }
                 }
-            }
-
-            static void Traverse(TProgram& program, IdGenerator& ids)
-            {
-                Traverse(program.getIntermediate(EShLangVertex), ids);
-                Traverse(program.getIntermediate(EShLangFragment), ids);
-            }
-
-        private:
-            static void Traverse(TIntermediate* intermediate, IdGenerator& ids)
-            {
-                SamplerSplitterTraverser traverser{};
-                intermediate->getTreeRoot()->traverse(&traverser);
 
                 TSourceLoc loc{};
                 loc.init();
@@ -622,7 +988,7 @@ namespace Babylon::ShaderCompilerTraversers
 
                 // Create all the new replacers.
                 unsigned int layoutBinding = 0;
-                for (const auto& [name, symbol] : traverser.m_samplerNameToSymbol)
+                for (const auto& [name, symbol] : samplerNameToSymbol)
                 {
                     // For each name and symbol, create a replacer.
                     const auto& type = symbol->getType();
@@ -707,71 +1073,121 @@ namespace Babylon::ShaderCompilerTraversers
                     }
                 }
 
-                makeReplacements(nameToReplacement, traverser.m_symbolsToParents);
-            }
+                makeReplacements(nameToReplacement, symbolsToParents);
 
-            std::map<std::string, TIntermSymbol*> m_samplerNameToSymbol{};
-            std::vector<std::pair<TIntermSymbol*, TIntermNode*>> m_symbolsToParents{};
+                // The original samplers no longer exist.
+                symbols.Samplers.clear();
+            }
         };
 
-        class InvertYDerivativeOperandsTraverser : public TIntermTraverser
+        class InvertYDerivativeOperandsModification final
         {
         public:
-            static void Traverse(TProgram& program)
+            static void Apply(TProgram& program, ProgramSymbols& symbols)
             {
                 auto intermediate{program.getIntermediate(EShLangFragment)};
-                InvertYDerivativeOperandsTraverser invertYDerivativeOperandsTraverser{intermediate};
-                intermediate->getTreeRoot()->traverse(&invertYDerivativeOperandsTraverser);
-            }
-
-        protected:
-            virtual bool visitUnary(TVisit visit, TIntermUnary* unary) override
-            {
-                if (visit == EvPreVisit)
+                for (auto* unary : symbols.Fragment.YDerivatives)
                 {
-                    auto op = unary->getOp();
-                    if (op == EOpDPdy || op == EOpDPdyFine || op == EOpDPdyCoarse)
-                    {
-                        unary->setOperand(m_intermediate->addUnaryNode(EOpNegative, unary->getOperand(), {}));
-                        return false;
-                    }
+                    unary->setOperand(intermediate->addUnaryNode(EOpNegative, unary->getOperand(), {}));
                 }
-
-                return true;
-            }
-
-        private:
-            InvertYDerivativeOperandsTraverser(TIntermediate* intermediate)
-                : m_intermediate{intermediate}
-            {
+                symbols.Fragment.YDerivatives.clear();
             }
+        };
 
-            TIntermediate* m_intermediate;
+        /// Owns the scopes of all the modifications performed by ModifyProgram.
+        class ModifyProgramScope final : public AllocationsScopeBase
+        {
+        public:
+            std::vector<ScopeT> Scopes{};
         };
     }
 
+    ScopeT ModifyProgram(TProgram& program, IdGenerator& ids, const Modifications& modifications, std::unordered_map<std::string, std::string>& vertexAttributeRenaming, std::unordered_map<std::string, ShaderCompiler::PackedUniform>& packedUniforms, ShaderCompiler::Statistics& statistics)
+    {
+        using Stage = ShaderCompiler::Statistics::Stage;
+        using ShaderCompilerCommon::StageTimer;
+
+        // The AST of each stage is traversed only once. The modifications are then performed
+        // in a fixed order from the symbols collected, which they keep up to date as they go.
+        ProgramSymbols symbols{};
+        {
+            StageTimer timer{statistics, Stage::CollectSymbols};
+            symbols = SymbolCollectionTraverser::Traverse(program);
+        }
+
+        auto scope = std::make_unique<ModifyProgramScope>();
+
+        if (modifications.PackUniforms)
+        {
+            StageTimer timer{statistics, Stage::PackUniforms};
+            UniformPackingModification::Apply(program, symbols, ids, packedUniforms);
+        }
+
+        if (modifications.ChangeUniformTypes)
+        {
+            StageTimer timer{statistics, Stage::ChangeUniformTypes};
+            scope->Scopes.push_back(UniformTypeChangeModification::Apply(program, symbols));
+        }
+
+        if (modifications.MoveNonSamplerUniformsIntoStruct)
+        {
+            StageTimer timer{statistics, Stage::MoveNonSamplerUniformsIntoStruct};
+            scope->Scopes.push_back(NonSamplerUniformToStructModification::Apply(program, symbols, ids));
+        }
+
+        {
+            StageTimer timer{statistics, Stage::AssignLocationsAndNamesToVertexVaryings};
+            VertexVaryingInModification::Apply(program, symbols, ids, vertexAttributeRenaming);
+        }
+
+        if (modifications.SplitSamplersIntoSamplersAndTextures)
+        {
+            StageTimer timer{statistics, Stage::SplitSamplersIntoSamplersAndTextures};
+            SamplerSplitterModification::Apply(program, symbols, ids);
+        }
+
+        if (modifications.InvertYDerivativeOperands)
+        {
+            StageTimer timer{statistics, Stage::InvertYDerivativeOperands};
+            InvertYDerivativeOperandsModification::Apply(program, symbols);
+        }
+
+        return scope;
+    }
+
     ScopeT MoveNonSamplerUniformsIntoStruct(TProgram& program, IdGenerator& ids)
     {
-        return NonSamplerUniformToStructTraverser::Traverse(program, ids);
+        auto symbols = SymbolCollectionTraverser::Traverse(program);
+        return NonSamplerUniformToStructModification::Apply(program, symbols, ids);
+    }
+
+    void PackUniforms(TProgram& program, IdGenerator& ids, std::unordered_map<std::string, ShaderCompiler::PackedUniform>& packedUniforms)
+    {
+        auto symbols = SymbolCollectionTraverser::Traverse(program);
+        UniformPackingModification::Apply(program, symbols, ids, packedUniforms);
     }
 
-    ScopeT ChangeUniformTypes(TProgram& program, IdGenerator& ids)
+    ScopeT ChangeUniformTypes(TProgram& program, IdGenerator&)
     {
-        return UniformTypeChangeTraverser::Traverse(program, ids);
+        auto symbols = SymbolCollectionTraverser::Traverse(program);
+        return UniformTypeChangeModification::Apply(program, symbols);
     }
 
     void AssignLocationsAndNamesToVertexVaryings(TProgram& program, IdGenerator& ids, std::unordered_map<std::string, std::string>& replacementToOriginalName)
     {
-        VertexVaryingInTraverser::Traverse(program, ids, replacementToOriginalName);
+        auto symbols = SymbolCollectionTraverser::Traverse(program);
+        VertexVaryingInModification::Apply(program, symbols, ids, replacementToOriginalName);
     }
 
     void SplitSamplersIntoSamplersAndTextures(TProgram& program, IdGenerator& ids)
     {
-        SamplerSplitterTraverser::Traverse(program, ids);
+        auto symbols = SymbolCollectionTraverser::Traverse(program);
+        SamplerSplitterModification::Apply(program, symbols, ids);
     }
 
     void InvertYDerivativeOperands(TProgram& program)
     {
-        InvertYDerivativeOperandsTraverser::Traverse(program);
+        auto symbols = SymbolCollectionTraverser::Traverse(program);
+        InvertYDerivativeOperandsModification::Apply(program, symbols);
     }
 }
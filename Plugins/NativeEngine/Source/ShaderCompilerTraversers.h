@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ShaderCompiler.h"
+
 #include <glslang/Public/ShaderLang.h>
 
 #include <memory>
@@ -60,6 +62,18 @@ namespace Babylon::ShaderCompilerTraversers
     ///     }
     ScopeT MoveNonSamplerUniformsIntoStruct(glslang::TProgram& program, IdGenerator& ids);
 
+    /// Packs float, vec2, and vec3 uniforms together into shared vec4 uniforms. Thus, if
+    /// the input shader has uniforms
+    ///
+    ///     vec3 vEyePosition;
+    ///     float alpha;
+    ///
+    /// then the shader will be modified to have a single vec4 uniform instead, whose xyz
+    /// components hold vEyePosition and w component holds alpha. Every uniform packed
+    /// this way is added to packedUniforms along with its location. Uniforms which would
+    /// be alone in their vec4 are left unchanged.
+    void PackUniforms(glslang::TProgram& program, IdGenerator& ids, std::unordered_map<std::string, ShaderCompiler::PackedUniform>& packedUniforms);
+
     /// Performs all changes to uniform types required by platforms that need changes.
     /// This is needed for Metal and OpenGL (not DirectX) to match bgfx's expectations
     /// that all uniforms, even scalars, are implemented as vec4 uniforms.
@@ -79,4 +93,24 @@ namespace Babylon::ShaderCompilerTraversers
     /// https://github.com/bkaradzic/bgfx/blob/7be225bf490bb1cd231cfb4abf7e617bf35b59cb/src/bgfx_shader.sh#L44-L45
     /// https://github.com/bkaradzic/bgfx/blob/7be225bf490bb1cd231cfb4abf7e617bf35b59cb/src/bgfx_shader.sh#L62-L65
     void InvertYDerivativeOperands(glslang::TProgram& program);
+
+    /// Selects the optional modifications performed by ModifyProgram. Each corresponds
+    /// to the function of the same name above.
+    struct Modifications
+    {
+        bool PackUniforms{false};
+        bool ChangeUniformTypes{false};
+        bool MoveNonSamplerUniformsIntoStruct{false};
+        bool SplitSamplersIntoSamplersAndTextures{false};
+        bool InvertYDerivativeOperands{false};
+    };
+
+    /// Performs the selected modifications as well as AssignLocationsAndNamesToVertexVaryings,
+    /// which every platform requires, in the order in which they are listed in Modifications,
+    /// with AssignLocationsAndNamesToVertexVaryings right after MoveNonSamplerUniformsIntoStruct.
+    /// This is equivalent to calling the functions above one after the other, except that the
+    /// symbols they operate on are collected by a single traversal of each shader stage
+    /// rather than by one traversal per function. The time taken by the traversal and by each
+    /// modification is added to the statistics.
+    ScopeT ModifyProgram(glslang::TProgram& program, IdGenerator& ids, const Modifications& modifications, std::unordered_map<std::string, std::string>& vertexAttributeRenaming, std::unordered_map<std::string, ShaderCompiler::PackedUniform>& packedUniforms, ShaderCompiler::Statistics& statistics);
 }
@@ -0,0 +1,65 @@
+#include "ShaderManifest.h"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace Babylon::ShaderManifest
+{
+    namespace
+    {
+        std::string GetDirectory(const std::string& path)
+        {
+            const auto separator = path.find_last_of("/\\");
+            return separator == std::string::npos ? std::string{} : path.substr(0, separator + 1);
+        }
+    }
+
+    std::string Program::GetName() const
+    {
+        return VertexPath + ", " + FragmentPath;
+    }
+
+    std::vector<Program> Load(const std::string& manifestPath)
+    {
+        const std::string directory{GetDirectory(manifestPath)};
+        std::istringstream manifest{ReadFile(manifestPath)};
+        std::vector<Program> programs{};
+
+        std::string line;
+        for (size_t lineNumber = 1; std::getline(manifest, line); ++lineNumber)
+        {
+            std::istringstream fields{line};
+            std::string vertexPath;
+            std::string fragmentPath;
+            if (!(fields >> vertexPath) || vertexPath[0] == '#')
+            {
+                continue;
+            }
+
+            if (!(fields >> fragmentPath))
+            {
+                throw std::runtime_error{manifestPath + "(" + std::to_string(lineNumber) + "): expected a vertex and a fragment shader."};
+            }
+
+            std::string vertexSource{ReadFile(directory + vertexPath)};
+            std::string fragmentSource{ReadFile(directory + fragmentPath)};
+            programs.push_back({std::move(vertexPath), std::move(fragmentPath), std::move(vertexSource), std::move(fragmentSource)});
+        }
+
+        return programs;
+    }
+
+    std::string ReadFile(const std::string& path)
+    {
+        std::ifstream file{path, std::ios::binary};
+        if (!file)
+        {
+            throw std::runtime_error{"Unable to open " + path + "."};
+        }
+
+        return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Babylon::ShaderManifest
+{
+    // Each line of a manifest names the files containing the vertex and fragment sources of one program,
+    // separated by whitespace and relative to the manifest. Empty lines and lines starting with # are ignored.
+    // Manifests are written by ShaderSourceDump and read by Apps/ShaderPrecompiler and
+    // Apps/ShaderCompilerBenchmark.
+    struct Program
+    {
+        std::string VertexPath;
+        std::string FragmentPath;
+        std::string VertexSource;
+        std::string FragmentSource;
+
+        // The paths of both shaders, to report errors against.
+        std::string GetName() const;
+    };
+
+    // Throws if the manifest or any of the files it names can't be read, or if a line is malformed.
+    std::vector<Program> Load(const std::string& manifestPath);
+
+    // Throws if the file can't be read.
+    std::string ReadFile(const std::string& path);
+}
@@ -0,0 +1,76 @@
+#include "ShaderSourceDump.h"
+#include "ShaderCache.h"
+#include "ShaderCompilationProfiler.h"
+
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <unordered_set>
+
+namespace Babylon::ShaderSourceDump
+{
+    namespace
+    {
+        std::mutex s_mutex{};
+        std::string s_directory{};
+        // The programs written to the directory so far.
+        std::unordered_set<uint64_t> s_keys{};
+
+        bool WriteFile(const std::string& path, std::string_view contents)
+        {
+            std::ofstream file{path, std::ios::binary | std::ios::trunc};
+            return file && file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+    }
+
+    void SetDirectory(std::string directory)
+    {
+        std::scoped_lock lock{s_mutex};
+        s_directory = std::move(directory);
+        s_keys.clear();
+    }
+
+    void Write(std::string_view vertexSource, std::string_view fragmentSource)
+    {
+        std::scoped_lock lock{s_mutex};
+
+        if (s_directory.empty())
+        {
+            return;
+        }
+
+        // Files are named after the key the program would have in the shader cache with the default options,
+        // which only serves to tell programs apart.
+        const uint64_t key{ShaderCache::ComputeKey(vertexSource, fragmentSource, {})};
+        if (!s_keys.insert(key).second)
+        {
+            return;
+        }
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        const std::string vertexName{std::string{name} + ".vertex.glsl"};
+        const std::string fragmentName{std::string{name} + ".fragment.glsl"};
+        const std::string vertexPath{s_directory + "/" + vertexName};
+
+        // Programs dumped by a previous run into the same directory are already in the manifest.
+        if (std::ifstream{vertexPath})
+        {
+            return;
+        }
+
+        // As with the shader cache, failing to write is not an error; the program is simply missing from the dump.
+        if (!WriteFile(vertexPath, vertexSource) || !WriteFile(s_directory + "/" + fragmentName, fragmentSource))
+        {
+            return;
+        }
+
+        std::ofstream manifest{s_directory + "/manifest.txt", std::ios::app};
+        const std::string shaderName{ShaderCompilationProfiler::GetShaderName(vertexSource)};
+        if (!shaderName.empty())
+        {
+            manifest << "# " << shaderName << "\n";
+        }
+        manifest << vertexName << " " << fragmentName << "\n";
+    }
+}
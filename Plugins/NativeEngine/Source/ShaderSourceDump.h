@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace Babylon::ShaderSourceDump
+{
+    // See Babylon::Plugins::NativeEngine::DumpShaderSources. Shared by all the NativeEngine instances of the
+    // process, which may create programs on different threads.
+    void SetDirectory(std::string directory);
+    void Write(std::string_view vertexSource, std::string_view fragmentSource);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <bgfx/bgfx.h>
+
+#include <array>
+#include <cstdint>
+
+namespace Babylon
+{
+    // Mirrors the draw state NativeEngine has handed to bgfx so that calls which would not change it can be
+    // skipped. Draws are submitted with flags that make bgfx keep this state from one draw to the next, so
+    // the mirror must be invalidated whenever bgfx drops it, i.e. on bgfx::frame and bgfx::discard.
+    //
+    // Each of the Set methods records the given value and returns whether it differs from the one bgfx
+    // already has, in other words whether the corresponding bgfx call needs to be made. Buffers are
+    // identified by a key uniquely identifying the bgfx handle, since that is what bgfx binds.
+    class ShadowState final
+    {
+    public:
+        // Matches BGFX_CONFIG_MAX_VERTEX_STREAMS as configured in Dependencies/CMakeLists.txt.
+        static constexpr uint8_t MaxVertexStreams{32};
+        // Texture stages beyond this are not shadowed and are always set.
+        static constexpr uint8_t MaxTextureStages{16};
+
+        bool SetState(uint64_t state)
+        {
+            if (m_stateValid && m_state == state)
+            {
+                return false;
+            }
+
+            m_state = state;
+            m_stateValid = true;
+            return true;
+        }
+
+        bool SetVertexStream(uint8_t stream, uint32_t bufferKey, uint32_t startVertex, uint16_t layoutIdx)
+        {
+            const uint32_t streamBit = 1u << stream;
+            VertexStream& shadow = m_vertexStreams[stream];
+            if ((m_vertexStreamMask & streamBit) != 0 && shadow.BufferKey == bufferKey && shadow.StartVertex == startVertex && shadow.LayoutIdx == layoutIdx)
+            {
+                return false;
+            }
+
+            shadow = {bufferKey, startVertex, layoutIdx};
+            m_vertexStreamMask |= streamBit;
+            return true;
+        }
+
+        // Records that the stream is bound to a buffer which isn't tracked, such as a transient buffer, so that
+        // the next call to SetVertexStream for it isn't skipped.
+        void SetVertexStreamUntracked(uint8_t stream)
+        {
+            m_vertexStreams[stream] = {UntrackedBufferKey, 0, bgfx::kInvalidHandle};
+            m_vertexStreamMask |= 1u << stream;
+        }
+
+        // Forgets the streams outside of the given mask and returns those among them which bgfx still has
+        // bound, so that they can be cleared.
+        uint32_t ReleaseVertexStreams(uint32_t keepMask)
+        {
+            const uint32_t released = m_vertexStreamMask & ~keepMask;
+            m_vertexStreamMask &= keepMask;
+            return released;
+        }
+
+        bool SetIndexBuffer(uint32_t bufferKey, uint32_t firstIndex, uint32_t numIndices)
+        {
+            if (m_indexBufferBound && m_indexBuffer.BufferKey == bufferKey && m_indexBuffer.FirstIndex == firstIndex && m_indexBuffer.NumIndices == numIndices)
+            {
+                return false;
+            }
+
+            m_indexBuffer = {bufferKey, firstIndex, numIndices};
+            m_indexBufferBound = true;
+            return true;
+        }
+
+        void SetIndexBufferUntracked()
+        {
+            m_indexBuffer = {UntrackedBufferKey, 0, 0};
+            m_indexBufferBound = true;
+        }
+
+        // Returns whether bgfx has an index buffer bound, in which case it must be discarded.
+        bool ClearIndexBuffer()
+        {
+            const bool wasBound = m_indexBufferBound;
+            m_indexBufferBound = false;
+            return wasBound;
+        }
+
+        bool SetTexture(uint8_t stage, uint16_t samplerIdx, uint16_t textureIdx, uint32_t flags)
+        {
+            if (stage >= MaxTextureStages)
+            {
+                return true;
+            }
+
+            TextureStage& shadow = m_textureStages[stage];
+            if (shadow.Valid && shadow.SamplerIdx == samplerIdx && shadow.TextureIdx == textureIdx && shadow.Flags == flags)
+            {
+                return false;
+            }
+
+            shadow = {samplerIdx, textureIdx, flags, true};
+            return true;
+        }
+
+        // bgfx::frame and bgfx::discard leave nothing bound, so afterwards neither does the mirror.
+        void Invalidate()
+        {
+            m_stateValid = false;
+            m_vertexStreamMask = 0;
+            m_indexBufferBound = false;
+            for (auto& textureStage : m_textureStages)
+            {
+                textureStage.Valid = false;
+            }
+        }
+
+    private:
+        // Never matches the key of a bgfx handle.
+        static constexpr uint32_t UntrackedBufferKey{UINT32_MAX};
+
+        struct VertexStream
+        {
+            uint32_t BufferKey{};
+            uint32_t StartVertex{};
+            uint16_t LayoutIdx{bgfx::kInvalidHandle};
+        };
+
+        struct IndexBuffer
+        {
+            uint32_t BufferKey{};
+            uint32_t FirstIndex{};
+            uint32_t NumIndices{};
+        };
+
+        struct TextureStage
+        {
+            uint16_t SamplerIdx{bgfx::kInvalidHandle};
+            uint16_t TextureIdx{bgfx::kInvalidHandle};
+            uint32_t Flags{};
+            bool Valid{false};
+        };
+
+        uint64_t m_state{};
+        bool m_stateValid{false};
+
+        std::array<VertexStream, MaxVertexStreams> m_vertexStreams{};
+        uint32_t m_vertexStreamMask{0};
+
+        IndexBuffer m_indexBuffer{};
+        bool m_indexBufferBound{false};
+
+        std::array<TextureStage, MaxTextureStages> m_textureStages{};
+    };
+}
@@ -364,7 +364,7 @@ namespace Babylon
                 }
                 else
                 {
-                    m_graphicsImpl.AddRenderWorkTask(arcana::make_task(m_engineImpl->RuntimeScheduler, arcana::cancellation::none(), [this, callback = std::move(callback)] {
+                    m_graphicsImpl.AddRenderWorkTask(arcana::make_task(m_engineImpl->FrameRuntimeScheduler, arcana::cancellation::none(), [this, callback = std::move(callback)] {
                         callback(*m_frame);
                     }));
                 }
@@ -381,9 +381,10 @@ namespace Babylon
             });
         }
 
-        void Dispatch(std::function<void()>&& callable)
+        template<typename CallableT>
+        void Dispatch(CallableT callable)
         {
-            m_engineImpl->Dispatch(callable);
+            m_engineImpl->Dispatch(std::move(callable));
         }
 
         xr::Size GetWidthAndHeightForViewIndex(size_t viewIndex) const
@@ -511,6 +512,7 @@ namespace Babylon
         if (frameBuffersDestroyed)
         {
             bgfx::frame();
+            m_engineImpl->InvalidateBgfxState();
         }
 
         m_texturesToFrameBuffers.clear();
@@ -575,6 +577,7 @@ namespace Babylon
                 // Force BGFX to create the texture now, which is necessary in order to use overrideInternal.
                 // TODO #555: Replace usage of bgfx::frame in NativeXR when creating/deleting frame buffers
                 bgfx::frame();
+                m_engineImpl->InvalidateBgfxState();
 
                 bgfx::overrideInternal(colorTex, colorTexPtr);
                 bgfx::overrideInternal(depthTex, reinterpret_cast<uintptr_t>(view.DepthTexturePointer));
@@ -0,0 +1,144 @@
+#include "TimeoutDispatcher.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Babylon::Polyfills::Internal
+{
+    TimeoutDispatcher::TimeoutDispatcher(JsRuntime& runtime)
+        : m_runtime{runtime}
+        , m_thread{[this] { ThreadProcedure(); }}
+    {
+    }
+
+    TimeoutDispatcher::~TimeoutDispatcher()
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_shutdown = true;
+            m_schedule.clear();
+        }
+
+        m_condition.notify_one();
+        m_thread.join();
+    }
+
+    TimeoutDispatcher::TimeoutId TimeoutDispatcher::Dispatch(std::shared_ptr<Napi::FunctionReference> function, std::chrono::milliseconds delay, bool repeat)
+    {
+        // As in browsers, negative delays are treated as 0.
+        delay = std::max(delay, std::chrono::milliseconds{0});
+
+        std::scoped_lock lock{m_mutex};
+
+        const TimeoutId id{NextTimeoutId()};
+        Timeout& timeout{m_timeouts.emplace(id, Timeout{std::move(function), delay, repeat, m_schedule.end()}).first->second};
+        Schedule(id, timeout, std::chrono::steady_clock::now() + delay);
+        return id;
+    }
+
+    void TimeoutDispatcher::Clear(TimeoutId id)
+    {
+        std::shared_ptr<Napi::FunctionReference> function{};
+        {
+            std::scoped_lock lock{m_mutex};
+
+            const auto timeout = m_timeouts.find(id);
+            if (timeout == m_timeouts.end())
+            {
+                return;
+            }
+
+            if (timeout->second.Scheduled != m_schedule.end())
+            {
+                m_schedule.erase(timeout->second.Scheduled);
+            }
+
+            function = std::move(timeout->second.Function);
+            m_timeouts.erase(timeout);
+        }
+
+        // The function is released here, on the JavaScript thread, outside of the lock.
+    }
+
+    TimeoutDispatcher::TimeoutId TimeoutDispatcher::NextTimeoutId()
+    {
+        // Ids are reused once they wrap around, skipping those still in use, as well as 0 which scripts
+        // commonly use to mean no timeout.
+        do
+        {
+            m_lastTimeoutId = m_lastTimeoutId == std::numeric_limits<TimeoutId>::max() ? 1 : m_lastTimeoutId + 1;
+        } while (m_timeouts.find(m_lastTimeoutId) != m_timeouts.end());
+
+        return m_lastTimeoutId;
+    }
+
+    void TimeoutDispatcher::Schedule(TimeoutId id, Timeout& timeout, TimePoint time)
+    {
+        const bool isEarliest{m_schedule.empty() || time < m_schedule.begin()->first};
+        timeout.Scheduled = m_schedule.emplace(time, id);
+
+        // Only wake up the thread if it has to wait for less time than it already does.
+        if (isEarliest)
+        {
+            m_condition.notify_one();
+        }
+    }
+
+    void TimeoutDispatcher::ThreadProcedure()
+    {
+        std::unique_lock lock{m_mutex};
+        while (!m_shutdown)
+        {
+            if (m_schedule.empty())
+            {
+                m_condition.wait(lock);
+                continue;
+            }
+
+            const auto next = m_schedule.begin();
+            if (std::chrono::steady_clock::now() < next->first)
+            {
+                m_condition.wait_until(lock, next->first);
+                continue;
+            }
+
+            const TimeoutId id{next->second};
+            m_timeouts.at(id).Scheduled = m_schedule.end();
+            m_schedule.erase(next);
+
+            lock.unlock();
+            m_runtime.Dispatch([this, id](Napi::Env) { CallFunction(id); });
+            lock.lock();
+        }
+    }
+
+    void TimeoutDispatcher::CallFunction(TimeoutId id)
+    {
+        std::shared_ptr<Napi::FunctionReference> function{};
+        {
+            std::scoped_lock lock{m_mutex};
+
+            // The timeout may have been cleared after being dispatched.
+            const auto timeout = m_timeouts.find(id);
+            if (timeout == m_timeouts.end())
+            {
+                return;
+            }
+
+            if (timeout->second.Repeat)
+            {
+                // Intervals are only rescheduled once dispatched calls actually run, so that at most one call
+                // is ever waiting on the JavaScript thread when it can't keep up with the interval.
+                function = timeout->second.Function;
+                Schedule(id, timeout->second, std::chrono::steady_clock::now() + timeout->second.Interval);
+            }
+            else
+            {
+                function = std::move(timeout->second.Function);
+                m_timeouts.erase(timeout);
+            }
+        }
+
+        function->Call({});
+    }
+}
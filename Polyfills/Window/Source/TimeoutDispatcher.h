@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Babylon/JsRuntime.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Babylon::Polyfills::Internal
+{
+    // Backs setTimeout and setInterval. Pending timeouts are kept sorted by due time and a dedicated thread
+    // sleeps until the earliest of them is due, at which point it dispatches its function to the JavaScript
+    // thread. Nothing runs on the JavaScript thread while waiting, so pending timeouts cost no CPU.
+    //
+    // Functions are only ever called and released on the JavaScript thread; the timer thread only deals
+    // with ids and due times.
+    class TimeoutDispatcher final
+    {
+    public:
+        using TimeoutId = int32_t;
+
+        TimeoutDispatcher(JsRuntime& runtime);
+        TimeoutDispatcher(const TimeoutDispatcher&) = delete;
+        ~TimeoutDispatcher();
+
+        // Schedules the function to be called after the delay and, if repeat is set, every delay thereafter
+        // until the timeout is cleared. Returns the id identifying the timeout, which is never 0.
+        TimeoutId Dispatch(std::shared_ptr<Napi::FunctionReference> function, std::chrono::milliseconds delay, bool repeat);
+
+        // Cancels the timeout with the given id, if it is still pending. Must be called on the JavaScript
+        // thread.
+        void Clear(TimeoutId id);
+
+    private:
+        using TimePoint = std::chrono::steady_clock::time_point;
+        using ScheduleT = std::multimap<TimePoint, TimeoutId>;
+
+        struct Timeout
+        {
+            std::shared_ptr<Napi::FunctionReference> Function;
+            std::chrono::milliseconds Interval;
+            bool Repeat;
+            // The entry of the timeout in m_schedule, so that clearing it doesn't have to search the schedule,
+            // or the end of m_schedule if it isn't waiting to be dispatched.
+            ScheduleT::iterator Scheduled;
+        };
+
+        TimeoutId NextTimeoutId();
+        void Schedule(TimeoutId id, Timeout& timeout, TimePoint time);
+        void ThreadProcedure();
+        void CallFunction(TimeoutId id);
+
+        JsRuntime& m_runtime;
+
+        std::mutex m_mutex{};
+        std::condition_variable m_condition{};
+        bool m_shutdown{false};
+
+        TimeoutId m_lastTimeoutId{0};
+        std::unordered_map<TimeoutId, Timeout> m_timeouts{};
+        // Timeouts waiting to be dispatched, by due time. Timeouts which have been dispatched to the JavaScript
+        // thread but not called yet are in m_timeouts only.
+        ScheduleT m_schedule{};
+
+        std::thread m_thread;
+    };
+}
@@ -9,6 +9,9 @@ namespace Babylon::Polyfills::Internal
     {
         constexpr auto JS_CLASS_NAME = "Window";
         constexpr auto JS_SET_TIMEOUT_NAME = "setTimeout";
+        constexpr auto JS_CLEAR_TIMEOUT_NAME = "clearTimeout";
+        constexpr auto JS_SET_INTERVAL_NAME = "setInterval";
+        constexpr auto JS_CLEAR_INTERVAL_NAME = "clearInterval";
         constexpr auto JS_A_TO_B_NAME = "atob";
         constexpr auto JS_ADD_EVENT_LISTENER_NAME = "addEventListener";
         constexpr auto JS_REMOVE_EVENT_LISTENER_NAME = "removeEventListener";
@@ -39,6 +42,22 @@ namespace Babylon::Polyfills::Internal
             global.Set(JS_SET_TIMEOUT_NAME, Napi::Function::New(env, &Window::SetTimeout, JS_SET_TIMEOUT_NAME, Window::Unwrap(jsWindow)));
         }
 
+        if (global.Get(JS_CLEAR_TIMEOUT_NAME).IsUndefined())
+        {
+            global.Set(JS_CLEAR_TIMEOUT_NAME, Napi::Function::New(env, &Window::ClearTimeout, JS_CLEAR_TIMEOUT_NAME, Window::Unwrap(jsWindow)));
+        }
+
+        if (global.Get(JS_SET_INTERVAL_NAME).IsUndefined())
+        {
+            global.Set(JS_SET_INTERVAL_NAME, Napi::Function::New(env, &Window::SetInterval, JS_SET_INTERVAL_NAME, Window::Unwrap(jsWindow)));
+        }
+
+        // Timeouts and intervals share their ids, so clearing either is the same operation.
+        if (global.Get(JS_CLEAR_INTERVAL_NAME).IsUndefined())
+        {
+            global.Set(JS_CLEAR_INTERVAL_NAME, Napi::Function::New(env, &Window::ClearTimeout, JS_CLEAR_INTERVAL_NAME, Window::Unwrap(jsWindow)));
+        }
+
         if (global.Get(JS_A_TO_B_NAME).IsUndefined())
         {
             global.Set(JS_A_TO_B_NAME, Napi::Function::New(env, &Window::DecodeBase64, JS_A_TO_B_NAME));
@@ -63,17 +82,30 @@ namespace Babylon::Polyfills::Internal
     Window::Window(const Napi::CallbackInfo& info)
         : Napi::ObjectWrap<Window>{info}
         , m_runtime{JsRuntime::GetFromJavaScript(info.Env())}
+        , m_timeoutDispatcher{m_runtime}
     {
     }
 
-    void Window::SetTimeout(const Napi::CallbackInfo& info)
+    Napi::Value Window::SetTimeout(const Napi::CallbackInfo& info)
     {
-        auto function = Napi::Persistent(info[0].As<Napi::Function>());
-        auto milliseconds = std::chrono::milliseconds{info[1].As<Napi::Number>().Int32Value()};
+        auto& window = *static_cast<Window*>(info.Data());
+        return window.Dispatch(info, false);
+    }
 
+    Napi::Value Window::SetInterval(const Napi::CallbackInfo& info)
+    {
         auto& window = *static_cast<Window*>(info.Data());
+        return window.Dispatch(info, true);
+    }
 
-        window.RecursiveWaitOrCall(std::make_shared<Napi::FunctionReference>(std::move(function)), std::chrono::system_clock::now() + milliseconds);
+    void Window::ClearTimeout(const Napi::CallbackInfo& info)
+    {
+        // Like browsers, silently ignore anything which isn't the id of a pending timeout.
+        if (info[0].IsNumber())
+        {
+            auto& window = *static_cast<Window*>(info.Data());
+            window.m_timeoutDispatcher.Clear(info[0].As<Napi::Number>().Int32Value());
+        }
     }
 
     Napi::Value Window::DecodeBase64(const Napi::CallbackInfo& info)
@@ -94,20 +126,14 @@ namespace Babylon::Polyfills::Internal
         // TODO: handle events
     }
 
-    void Window::RecursiveWaitOrCall(
-        std::shared_ptr<Napi::FunctionReference> function,
-        std::chrono::system_clock::time_point whenToRun)
+    Napi::Value Window::Dispatch(const Napi::CallbackInfo& info, bool repeat)
     {
-        m_runtime.Dispatch([this, function = std::move(function), whenToRun](Napi::Env) {
-            if (std::chrono::system_clock::now() >= whenToRun)
-            {
-                function->Call({});
-            }
-            else
-            {
-                RecursiveWaitOrCall(std::move(function), whenToRun);
-            }
-        });
+        auto function = std::make_shared<Napi::FunctionReference>(Napi::Persistent(info[0].As<Napi::Function>()));
+
+        // A missing delay means as soon as possible.
+        const auto delay = std::chrono::milliseconds{info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : 0};
+
+        return Napi::Value::From(info.Env(), m_timeoutDispatcher.Dispatch(std::move(function), delay, repeat));
     }
 }
 
@@ -2,6 +2,8 @@
 
 #include <Babylon/JsRuntime.h>
 
+#include "TimeoutDispatcher.h"
+
 namespace Babylon::Polyfills::Internal
 {
     class Window : public Napi::ObjectWrap<Window>
@@ -16,12 +18,15 @@ namespace Babylon::Polyfills::Internal
 
     private:
         JsRuntime& m_runtime;
+        TimeoutDispatcher m_timeoutDispatcher;
 
-        static void SetTimeout(const Napi::CallbackInfo& info);
+        static Napi::Value SetTimeout(const Napi::CallbackInfo& info);
+        static Napi::Value SetInterval(const Napi::CallbackInfo& info);
+        static void ClearTimeout(const Napi::CallbackInfo& info);
         static Napi::Value DecodeBase64(const Napi::CallbackInfo& info);
         static void AddEventListener(const Napi::CallbackInfo& info);
         static void RemoveEventListener(const Napi::CallbackInfo& info);
 
-        void RecursiveWaitOrCall(std::shared_ptr<Napi::FunctionReference> function, std::chrono::system_clock::time_point whenToRun);
+        Napi::Value Dispatch(const Napi::CallbackInfo& info, bool repeat);
     };
 }
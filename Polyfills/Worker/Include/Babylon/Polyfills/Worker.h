@@ -0,0 +1,16 @@
+#pragma once
+
+#include <napi/env.h>
+
+#include <functional>
+
+namespace Babylon::Polyfills::Worker
+{
+    /**
+     * Called on the thread of each new worker, before its script runs, to initialize the polyfills and
+     * plugins of its JavaScript environment.
+     */
+    using InitializeCallbackT = std::function<void(Napi::Env)>;
+
+    void Initialize(Napi::Env env, InitializeCallbackT initializeCallback);
+}
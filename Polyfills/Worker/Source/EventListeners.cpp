@@ -0,0 +1,75 @@
+#include "EventListeners.h"
+
+namespace Babylon::Polyfills::Internal
+{
+    void EventListeners::Add(const Napi::CallbackInfo& info)
+    {
+        std::string eventType = info[0].As<Napi::String>().Utf8Value();
+        Napi::Function eventHandler = info[1].As<Napi::Function>();
+
+        auto& eventHandlerRefs = m_eventHandlerRefs[eventType];
+        for (const auto& eventHandlerRef : eventHandlerRefs)
+        {
+            // As in browsers, adding the same listener again has no effect.
+            if (eventHandlerRef.Value() == eventHandler)
+            {
+                return;
+            }
+        }
+
+        eventHandlerRefs.push_back(Napi::Persistent(eventHandler));
+    }
+
+    void EventListeners::Remove(const Napi::CallbackInfo& info)
+    {
+        std::string eventType = info[0].As<Napi::String>().Utf8Value();
+        Napi::Function eventHandler = info[1].As<Napi::Function>();
+
+        auto itType = m_eventHandlerRefs.find(eventType);
+        if (itType != m_eventHandlerRefs.end())
+        {
+            auto& eventHandlerRefs = itType->second;
+            for (auto it = eventHandlerRefs.begin(); it != eventHandlerRefs.end(); ++it)
+            {
+                if (it->Value() == eventHandler)
+                {
+                    eventHandlerRefs.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    void EventListeners::Raise(Napi::Object target, const std::string& type, Napi::Object event) const
+    {
+        event.Set("type", type);
+        event.Set("target", target);
+
+        const auto handler = target.Get("on" + type);
+        if (handler.IsFunction())
+        {
+            handler.As<Napi::Function>().Call(target, {event});
+        }
+
+        auto it = m_eventHandlerRefs.find(type);
+        if (it != m_eventHandlerRefs.end())
+        {
+            // Listeners may add or remove listeners, so call the ones there were when the event was raised.
+            std::vector<Napi::Function> eventHandlers{};
+            for (const auto& eventHandlerRef : it->second)
+            {
+                eventHandlers.push_back(eventHandlerRef.Value());
+            }
+
+            for (const auto& eventHandler : eventHandlers)
+            {
+                eventHandler.Call(target, {event});
+            }
+        }
+    }
+
+    void EventListeners::Clear()
+    {
+        m_eventHandlerRefs.clear();
+    }
+}
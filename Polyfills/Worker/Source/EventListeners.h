@@ -0,0 +1,27 @@
+#pragma once
+
+#include <napi/napi.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Babylon::Polyfills::Internal
+{
+    // The event listeners of a Worker or of the global scope of a worker, which both only raise a few kinds of
+    // events.
+    class EventListeners final
+    {
+    public:
+        void Add(const Napi::CallbackInfo& info);
+        void Remove(const Napi::CallbackInfo& info);
+
+        // Calls the on<type> property of the target, if it is a function, and then the listeners of the type.
+        void Raise(Napi::Object target, const std::string& type, Napi::Object event) const;
+
+        void Clear();
+
+    private:
+        std::unordered_map<std::string, std::vector<Napi::FunctionReference>> m_eventHandlerRefs{};
+    };
+}
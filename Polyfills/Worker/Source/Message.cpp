@@ -0,0 +1,449 @@
+#include "Message.h"
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Babylon::Polyfills::Internal
+{
+    namespace
+    {
+        Napi::Error CreateDataCloneError(Napi::Env env, const std::string& message)
+        {
+            auto error = Napi::Error::New(env, message);
+            error.Set("name", "DataCloneError");
+            return error;
+        }
+
+        // The types CreateTypedArray supports, which exclude BigInt64Array and BigUint64Array.
+        bool IsSupportedTypedArrayType(napi_typedarray_type type)
+        {
+            switch (type)
+            {
+            case napi_int8_array:
+            case napi_uint8_array:
+            case napi_uint8_clamped_array:
+            case napi_int16_array:
+            case napi_uint16_array:
+            case napi_int32_array:
+            case napi_uint32_array:
+            case napi_float32_array:
+            case napi_float64_array:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        Napi::Value CreateTypedArray(Napi::Env env, napi_typedarray_type type, size_t length, Napi::ArrayBuffer arrayBuffer, size_t byteOffset)
+        {
+            switch (type)
+            {
+            case napi_int8_array:
+                return Napi::Int8Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_uint8_array:
+                return Napi::Uint8Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_uint8_clamped_array:
+                return Napi::Uint8Array::New(env, length, arrayBuffer, byteOffset, napi_uint8_clamped_array);
+            case napi_int16_array:
+                return Napi::Int16Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_uint16_array:
+                return Napi::Uint16Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_int32_array:
+                return Napi::Int32Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_uint32_array:
+                return Napi::Uint32Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_float32_array:
+                return Napi::Float32Array::New(env, length, arrayBuffer, byteOffset);
+            case napi_float64_array:
+                return Napi::Float64Array::New(env, length, arrayBuffer, byteOffset);
+            default:
+                throw std::runtime_error{"Unsupported typed array type"};
+            }
+        }
+    }
+
+    // Memory backing ArrayBuffers handed from one environment to another.
+    class Message::Buffer final
+    {
+    public:
+        static std::shared_ptr<Buffer> Create(size_t byteLength)
+        {
+            std::shared_ptr<Buffer> buffer{new Buffer{byteLength}};
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+            auto& registry = GetRegistry();
+            std::scoped_lock lock{registry.Mutex};
+            registry.Buffers[buffer->Data()] = buffer;
+#endif
+            return buffer;
+        }
+
+        // Returns the buffer an external ArrayBuffer was created over by Deserialize, if the engine can detach
+        // the ArrayBuffer so that the buffer can be handed over as is.
+        static std::shared_ptr<Buffer> FindTransferable(Napi::ArrayBuffer arrayBuffer)
+        {
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+            auto& registry = GetRegistry();
+            std::scoped_lock lock{registry.Mutex};
+            const auto entry = registry.Buffers.find(arrayBuffer.Data());
+            if (entry != registry.Buffers.end())
+            {
+                auto buffer = entry->second.lock();
+                if (buffer != nullptr && buffer->ByteLength() == arrayBuffer.ByteLength())
+                {
+                    return buffer;
+                }
+            }
+#else
+            (void)arrayBuffer;
+#endif
+            return {};
+        }
+
+        Buffer(const Buffer&) = delete;
+
+        ~Buffer()
+        {
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+            auto& registry = GetRegistry();
+            std::scoped_lock lock{registry.Mutex};
+            registry.Buffers.erase(Data());
+#endif
+        }
+
+        std::byte* Data() const
+        {
+            return m_data.get();
+        }
+
+        size_t ByteLength() const
+        {
+            return m_byteLength;
+        }
+
+    private:
+        explicit Buffer(size_t byteLength)
+            : m_data{std::make_unique<std::byte[]>(byteLength)}
+            , m_byteLength{byteLength}
+        {
+        }
+
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+        // Buffers by the address of their memory, which is also that of the ArrayBuffers over them. Shared by
+        // all environments, as buffers move from one to another.
+        struct Registry
+        {
+            std::mutex Mutex{};
+            std::unordered_map<const void*, std::weak_ptr<Buffer>> Buffers{};
+        };
+
+        static Registry& GetRegistry()
+        {
+            static Registry registry{};
+            return registry;
+        }
+#endif
+
+        std::unique_ptr<std::byte[]> m_data;
+        size_t m_byteLength;
+    };
+
+    class Message::Serializer final
+    {
+    public:
+        Serializer(Message& message, Napi::Value transfer)
+            : m_message{message}
+        {
+            if (transfer.IsUndefined() || transfer.IsNull())
+            {
+                return;
+            }
+
+            // Like postMessage, takes either the transfer list or an options object with a transfer property.
+            if (transfer.IsObject() && !transfer.IsArray())
+            {
+                transfer = transfer.As<Napi::Object>().Get("transfer");
+                if (transfer.IsUndefined())
+                {
+                    return;
+                }
+            }
+
+            if (!transfer.IsArray())
+            {
+                throw Napi::TypeError::New(transfer.Env(), "The transfer list must be an array.");
+            }
+
+            const auto transferList = transfer.As<Napi::Array>();
+            for (uint32_t index = 0; index < transferList.Length(); ++index)
+            {
+                const auto value = transferList.Get(index);
+                if (!value.IsArrayBuffer())
+                {
+                    throw CreateDataCloneError(transfer.Env(), "Only ArrayBuffers can be transferred.");
+                }
+
+                const auto arrayBuffer = value.As<Napi::ArrayBuffer>();
+                for (const auto& transferred : m_transferred)
+                {
+                    if (transferred.ArrayBuffer.StrictEquals(arrayBuffer))
+                    {
+                        throw CreateDataCloneError(transfer.Env(), "An ArrayBuffer can only be transferred once.");
+                    }
+                }
+
+                // Transferred ArrayBuffers which can't be handed over are copied like the others: handing their
+                // memory over would let the sender, which keeps access to it, race with the receiver.
+                m_transferred.push_back({arrayBuffer, Buffer::FindTransferable(arrayBuffer)});
+            }
+        }
+
+        // Detaches the ArrayBuffers whose memory the message took over, once the whole value has been added, so
+        // that the sender keeps them if it can't be cloned.
+        void DetachTransferred()
+        {
+#ifdef NAPI_HAS_DETACH_ARRAYBUFFER
+            for (auto& transferred : m_transferred)
+            {
+                if (transferred.Memory != nullptr)
+                {
+                    transferred.ArrayBuffer.Detach();
+                }
+            }
+#endif
+        }
+
+        // Returns the index of the node of the value.
+        size_t Add(Napi::Value value)
+        {
+            const size_t index{m_message.m_nodes.size()};
+            m_message.m_nodes.emplace_back();
+
+            // Adding the properties of arrays and objects adds nodes, which moves the nodes around.
+            const auto node = [this, index]() -> Node& { return m_message.m_nodes[index]; };
+
+            switch (value.Type())
+            {
+            case napi_undefined:
+                node().Type = ValueType::Undefined;
+                break;
+            case napi_null:
+                node().Type = ValueType::Null;
+                break;
+            case napi_boolean:
+                node().Type = ValueType::Boolean;
+                node().Boolean = value.As<Napi::Boolean>().Value();
+                break;
+            case napi_number:
+                node().Type = ValueType::Number;
+                node().Number = value.As<Napi::Number>().DoubleValue();
+                break;
+            case napi_string:
+                node().Type = ValueType::String;
+                node().String = value.As<Napi::String>().Utf8Value();
+                break;
+            case napi_object:
+                if (value.IsArrayBuffer())
+                {
+                    node().Type = ValueType::ArrayBuffer;
+                    node().BufferIndex = AddBuffer(value.As<Napi::ArrayBuffer>());
+                }
+                else if (value.IsTypedArray())
+                {
+                    const auto typedArray = value.As<Napi::TypedArray>();
+
+                    // Rejected here rather than when the message is deserialized, on the thread of the receiver.
+                    if (!IsSupportedTypedArrayType(typedArray.TypedArrayType()))
+                    {
+                        throw CreateDataCloneError(value.Env(), "BigInt typed arrays can't be cloned.");
+                    }
+
+                    node().Type = ValueType::TypedArray;
+                    node().BufferIndex = AddBuffer(typedArray.ArrayBuffer());
+                    node().TypedArrayType = typedArray.TypedArrayType();
+                    node().ByteOffset = typedArray.ByteOffset();
+                    node().Length = typedArray.ElementLength();
+                }
+                else if (value.IsDataView())
+                {
+                    const auto dataView = value.As<Napi::DataView>();
+                    node().Type = ValueType::DataView;
+                    node().BufferIndex = AddBuffer(dataView.ArrayBuffer());
+                    node().ByteOffset = dataView.ByteOffset();
+                    node().Length = dataView.ByteLength();
+                }
+                else
+                {
+                    AddProperties(index, value.As<Napi::Object>());
+                }
+                break;
+            default:
+                throw CreateDataCloneError(value.Env(), "Functions, symbols and external values can't be cloned.");
+            }
+
+            return index;
+        }
+
+    private:
+        void AddProperties(size_t index, Napi::Object object)
+        {
+            for (const auto& ancestor : m_ancestors)
+            {
+                if (ancestor.StrictEquals(object))
+                {
+                    throw CreateDataCloneError(object.Env(), "Values referencing themselves can't be cloned.");
+                }
+            }
+
+            m_ancestors.push_back(object);
+
+            if (object.IsArray())
+            {
+                m_message.m_nodes[index].Type = ValueType::Array;
+
+                const auto array = object.As<Napi::Array>();
+                for (uint32_t element = 0; element < array.Length(); ++element)
+                {
+                    const size_t valueIndex{Add(array.Get(element))};
+                    m_message.m_nodes[index].Values.push_back(valueIndex);
+                }
+            }
+            else
+            {
+                m_message.m_nodes[index].Type = ValueType::Object;
+
+                const auto names = object.GetPropertyNames();
+                for (uint32_t property = 0; property < names.Length(); ++property)
+                {
+                    const auto name = names.Get(property);
+                    const size_t valueIndex{Add(object.Get(name))};
+                    m_message.m_nodes[index].Keys.push_back(name.ToString().Utf8Value());
+                    m_message.m_nodes[index].Values.push_back(valueIndex);
+                }
+            }
+
+            m_ancestors.pop_back();
+        }
+
+        size_t AddBuffer(Napi::ArrayBuffer arrayBuffer)
+        {
+            // ArrayBuffers viewed several times are only cloned once.
+            for (size_t index = 0; index < m_arrayBuffers.size(); ++index)
+            {
+                if (m_arrayBuffers[index].StrictEquals(arrayBuffer))
+                {
+                    return index;
+                }
+            }
+
+            std::shared_ptr<Buffer> buffer{};
+            for (const auto& transferred : m_transferred)
+            {
+                if (transferred.ArrayBuffer.StrictEquals(arrayBuffer))
+                {
+                    buffer = transferred.Memory;
+                }
+            }
+
+            if (buffer == nullptr)
+            {
+                buffer = Buffer::Create(arrayBuffer.ByteLength());
+                if (buffer->ByteLength() != 0)
+                {
+                    std::memcpy(buffer->Data(), arrayBuffer.Data(), buffer->ByteLength());
+                }
+            }
+
+            m_arrayBuffers.push_back(arrayBuffer);
+            m_message.m_buffers.push_back(std::move(buffer));
+            return m_arrayBuffers.size() - 1;
+        }
+
+        struct Transferred
+        {
+            Napi::ArrayBuffer ArrayBuffer;
+            // The memory of the ArrayBuffer, if it can be handed over as is.
+            std::shared_ptr<Buffer> Memory;
+        };
+
+        Message& m_message;
+        std::vector<Transferred> m_transferred{};
+        // The ArrayBuffers of the message so far, by buffer index.
+        std::vector<Napi::ArrayBuffer> m_arrayBuffers{};
+        // The arrays and objects being added, to detect cycles.
+        std::vector<Napi::Object> m_ancestors{};
+    };
+
+    Message Message::Serialize(Napi::Value value, Napi::Value transfer)
+    {
+        Message message{};
+        Serializer serializer{message, transfer};
+        serializer.Add(value);
+        serializer.DetachTransferred();
+        return message;
+    }
+
+    Napi::Value Message::Deserialize(Napi::Env env) const
+    {
+        std::vector<Napi::ArrayBuffer> arrayBuffers(m_buffers.size());
+        return Deserialize(env, 0, arrayBuffers);
+    }
+
+    Napi::Value Message::Deserialize(Napi::Env env, size_t index, std::vector<Napi::ArrayBuffer>& arrayBuffers) const
+    {
+        const Node& node{m_nodes[index]};
+
+        const auto getArrayBuffer = [this, env, &node, &arrayBuffers]() {
+            auto& arrayBuffer = arrayBuffers[node.BufferIndex];
+            if (arrayBuffer.IsEmpty())
+            {
+                // The ArrayBuffer keeps the buffer alive, wherever else it is also referenced from.
+                const auto& buffer = m_buffers[node.BufferIndex];
+                arrayBuffer = Napi::ArrayBuffer::New(env, buffer->Data(), buffer->ByteLength(), [buffer](Napi::Env, void*) {});
+            }
+
+            return arrayBuffer;
+        };
+
+        switch (node.Type)
+        {
+        case ValueType::Undefined:
+            return env.Undefined();
+        case ValueType::Null:
+            return env.Null();
+        case ValueType::Boolean:
+            return Napi::Boolean::New(env, node.Boolean);
+        case ValueType::Number:
+            return Napi::Number::New(env, node.Number);
+        case ValueType::String:
+            return Napi::String::New(env, node.String);
+        case ValueType::Array:
+        {
+            auto array = Napi::Array::New(env, node.Values.size());
+            for (size_t element = 0; element < node.Values.size(); ++element)
+            {
+                array.Set(static_cast<uint32_t>(element), Deserialize(env, node.Values[element], arrayBuffers));
+            }
+            return std::move(array);
+        }
+        case ValueType::Object:
+        {
+            auto object = Napi::Object::New(env);
+            for (size_t property = 0; property < node.Values.size(); ++property)
+            {
+                object.Set(node.Keys[property], Deserialize(env, node.Values[property], arrayBuffers));
+            }
+            return std::move(object);
+        }
+        case ValueType::ArrayBuffer:
+            return getArrayBuffer();
+        case ValueType::TypedArray:
+            return CreateTypedArray(env, node.TypedArrayType, node.Length, getArrayBuffer(), node.ByteOffset);
+        case ValueType::DataView:
+            return Napi::DataView::New(env, getArrayBuffer(), node.ByteOffset, node.Length);
+        }
+
+        throw std::runtime_error{"Invalid message value type"};
+    }
+}
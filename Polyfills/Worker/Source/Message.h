@@ -0,0 +1,76 @@
+#pragma once
+
+#include <napi/napi.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Babylon::Polyfills::Internal
+{
+    // A JavaScript value taken out of one environment to be recreated in another, along the lines of the
+    // structured clone algorithm. Supports what scripts commonly exchange with workers: primitives, arrays,
+    // plain objects, ArrayBuffers, typed arrays other than BigInt ones, and DataViews. Objects referenced
+    // more than once are cloned once per reference, except for ArrayBuffers, and cycles are rejected.
+    //
+    // The ArrayBuffers of a message are copied once, when it is serialized, and their copies are handed over
+    // as is to the environment receiving it, as external ArrayBuffers. Where the engine can detach
+    // ArrayBuffers (see NAPI_HAS_DETACH_ARRAYBUFFER), transferring such an ArrayBuffer on hands its memory
+    // over without a copy, and detaches it from the sender as browsers do. Other transferred ArrayBuffers,
+    // which are either created by scripts and backed by memory the engine owns, or on an engine which can't
+    // detach them, are copied instead, and the sender keeps using its own.
+    class Message final
+    {
+    public:
+        // The transfer list can also be given as the transfer property of an object, as postMessage accepts
+        // both. Throws a DataCloneError for values which can't be cloned, or for transfer lists which
+        // contain anything but ArrayBuffers.
+        static Message Serialize(Napi::Value value, Napi::Value transfer);
+
+        // Must only be called once, as the ArrayBuffers of the message are handed over to the environment.
+        Napi::Value Deserialize(Napi::Env env) const;
+
+    private:
+        class Buffer;
+        class Serializer;
+
+        enum class ValueType
+        {
+            Undefined,
+            Null,
+            Boolean,
+            Number,
+            String,
+            Array,
+            Object,
+            ArrayBuffer,
+            TypedArray,
+            DataView,
+        };
+
+        struct Node
+        {
+            ValueType Type{ValueType::Undefined};
+            bool Boolean{};
+            double Number{};
+            std::string String{};
+
+            // The properties of arrays and objects, as indices in m_nodes, and their names for objects.
+            std::vector<std::string> Keys{};
+            std::vector<size_t> Values{};
+
+            // ArrayBuffers and views of them. The length is in elements for typed arrays, in bytes otherwise.
+            size_t BufferIndex{};
+            napi_typedarray_type TypedArrayType{};
+            size_t ByteOffset{};
+            size_t Length{};
+        };
+
+        Napi::Value Deserialize(Napi::Env env, size_t index, std::vector<Napi::ArrayBuffer>& arrayBuffers) const;
+
+        // The value is the first node.
+        std::vector<Node> m_nodes{};
+        std::vector<std::shared_ptr<Buffer>> m_buffers{};
+    };
+}
@@ -0,0 +1,172 @@
+#include "Worker.h"
+#include "WorkerScope.h"
+
+#include <Babylon/JsRuntime.h>
+
+namespace Babylon::Polyfills::Internal
+{
+    namespace
+    {
+        constexpr auto JS_CLASS_NAME = "Worker";
+        constexpr auto JS_INITIALIZE_CALLBACK_NAME = "workerInitializeCallback";
+
+        namespace EventType
+        {
+            constexpr const char* Message = "message";
+            constexpr const char* Error = "error";
+        }
+    }
+
+    void Worker::Initialize(Napi::Env env, Polyfills::Worker::InitializeCallbackT initializeCallback)
+    {
+        Napi::HandleScope scope{env};
+
+        Napi::Function func = DefineClass(
+            env,
+            JS_CLASS_NAME,
+            {
+                InstanceMethod("postMessage", &Worker::PostMessage),
+                InstanceMethod("terminate", &Worker::Terminate),
+                InstanceMethod("addEventListener", &Worker::AddEventListener),
+                InstanceMethod("removeEventListener", &Worker::RemoveEventListener),
+            });
+
+        if (env.Global().Get(JS_CLASS_NAME).IsUndefined())
+        {
+            env.Global().Set(JS_CLASS_NAME, func);
+        }
+
+        auto jsNative = JsRuntime::NativeObject::GetFromJavaScript(env);
+        jsNative.Set(JS_CLASS_NAME, func);
+
+        using InitializeCallbackT = Polyfills::Worker::InitializeCallbackT;
+        jsNative.Set(JS_INITIALIZE_CALLBACK_NAME, Napi::External<InitializeCallbackT>::New(env, new InitializeCallbackT{std::move(initializeCallback)}, [](Napi::Env, InitializeCallbackT* callback) { delete callback; }));
+    }
+
+    Worker::Worker(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<Worker>{info}
+        , m_channel{std::make_shared<WorkerChannel>(JsRuntime::GetFromJavaScript(info.Env()))}
+    {
+        if (!info[0].IsString())
+        {
+            throw Napi::TypeError::New(info.Env(), "The script URL of a Worker must be a string.");
+        }
+
+        auto url = info[0].As<Napi::String>().Utf8Value();
+        auto initializeCallback = *JsRuntime::NativeObject::GetFromJavaScript(info.Env()).Get(JS_INITIALIZE_CALLBACK_NAME).As<Napi::External<Polyfills::Worker::InitializeCallbackT>>().Data();
+
+        // As in browsers, errors the worker doesn't handle are raised on the Worker.
+        m_runtime = std::make_unique<AppRuntime>([channel{m_channel}](std::exception_ptr exception) {
+            std::string message{"Uncaught error"};
+            try
+            {
+                std::rethrow_exception(exception);
+            }
+            catch (const Napi::Error& error)
+            {
+                message = error.Message();
+            }
+            catch (const std::exception& error)
+            {
+                message = error.what();
+            }
+            catch (...)
+            {
+            }
+
+            channel->DispatchToParent([message{std::move(message)}](Worker& worker, Napi::Env) {
+                worker.RaiseError(message);
+            });
+        });
+
+        m_channel->Open(*this, *m_runtime);
+
+        // The scope of the worker is set up first, so that polyfills which only fill in what is missing from the
+        // global object leave its postMessage and event listeners alone.
+        m_runtime->Dispatch([channel{m_channel}, initializeCallback{std::move(initializeCallback)}](Napi::Env env) {
+            WorkerScope::Initialize(env, channel);
+            initializeCallback(env);
+        });
+
+        m_scriptLoader = std::make_unique<ScriptLoader>([channel{m_channel}](std::function<void(Napi::Env)> work) {
+            channel->DispatchToWorker(std::move(work));
+        });
+        m_scriptLoader->LoadScript(std::move(url));
+
+        Ref();
+    }
+
+    Worker::~Worker()
+    {
+        Stop();
+    }
+
+    void Worker::RaiseMessage(const Message& message)
+    {
+        Napi::HandleScope scope{Env()};
+
+        auto event = Napi::Object::New(Env());
+        event.Set("data", message.Deserialize(Env()));
+        m_eventListeners.Raise(Value(), EventType::Message, event);
+    }
+
+    void Worker::RaiseError(const std::string& message)
+    {
+        Napi::HandleScope scope{Env()};
+
+        auto event = Napi::Object::New(Env());
+        event.Set("message", message);
+        m_eventListeners.Raise(Value(), EventType::Error, event);
+    }
+
+    void Worker::Close()
+    {
+        if (m_runtime != nullptr)
+        {
+            Stop();
+            Unref();
+        }
+    }
+
+    void Worker::PostMessage(const Napi::CallbackInfo& info)
+    {
+        m_channel->DispatchToWorker([message{Message::Serialize(info[0], info[1])}](Napi::Env env) {
+            WorkerScope::GetFromJavaScript(env).RaiseMessage(message);
+        });
+    }
+
+    void Worker::Terminate(const Napi::CallbackInfo&)
+    {
+        Close();
+    }
+
+    void Worker::AddEventListener(const Napi::CallbackInfo& info)
+    {
+        m_eventListeners.Add(info);
+    }
+
+    void Worker::RemoveEventListener(const Napi::CallbackInfo& info)
+    {
+        m_eventListeners.Remove(info);
+    }
+
+    void Worker::Stop()
+    {
+        // Whatever either side dispatched to the other from now on is dropped.
+        m_channel->Close();
+        m_scriptLoader.reset();
+
+        // Waits for the work the worker is running, if any, to complete, as scripts can't be interrupted.
+        m_runtime.reset();
+
+        m_eventListeners.Clear();
+    }
+}
+
+namespace Babylon::Polyfills::Worker
+{
+    void Initialize(Napi::Env env, InitializeCallbackT initializeCallback)
+    {
+        Internal::Worker::Initialize(env, std::move(initializeCallback));
+    }
+}
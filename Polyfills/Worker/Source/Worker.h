@@ -0,0 +1,48 @@
+#pragma once
+
+#include "EventListeners.h"
+#include "Message.h"
+#include "WorkerChannel.h"
+
+#include <Babylon/AppRuntime.h>
+#include <Babylon/Polyfills/Worker.h>
+#include <Babylon/ScriptLoader.h>
+
+#include <napi/napi.h>
+
+#include <memory>
+
+namespace Babylon::Polyfills::Internal
+{
+    // Runs a script on its own AppRuntime, and thus its own thread and JavaScript environment, which it only
+    // shares messages with. The worker keeps running until it is terminated, from either side, even when
+    // nothing references the Worker anymore.
+    class Worker final : public Napi::ObjectWrap<Worker>
+    {
+    public:
+        static void Initialize(Napi::Env env, Polyfills::Worker::InitializeCallbackT initializeCallback);
+
+        explicit Worker(const Napi::CallbackInfo& info);
+        ~Worker();
+
+        // Called through the channel, on the thread of the environment which created the worker.
+        void RaiseMessage(const Message& message);
+        void RaiseError(const std::string& message);
+
+        // Stops the worker, if it is still running, and lets the Worker be garbage collected.
+        void Close();
+
+    private:
+        void PostMessage(const Napi::CallbackInfo& info);
+        void Terminate(const Napi::CallbackInfo& info);
+        void AddEventListener(const Napi::CallbackInfo& info);
+        void RemoveEventListener(const Napi::CallbackInfo& info);
+
+        void Stop();
+
+        std::shared_ptr<WorkerChannel> m_channel{};
+        std::unique_ptr<AppRuntime> m_runtime{};
+        std::unique_ptr<ScriptLoader> m_scriptLoader{};
+        EventListeners m_eventListeners{};
+    };
+}
@@ -0,0 +1,49 @@
+#include "WorkerChannel.h"
+#include "Worker.h"
+
+namespace Babylon::Polyfills::Internal
+{
+    WorkerChannel::WorkerChannel(JsRuntime& parentRuntime)
+        : m_parentRuntime{&parentRuntime}
+    {
+    }
+
+    void WorkerChannel::Open(Worker& worker, AppRuntime& workerRuntime)
+    {
+        std::scoped_lock lock{m_mutex};
+        m_worker = &worker;
+        m_workerRuntime = &workerRuntime;
+    }
+
+    void WorkerChannel::Close()
+    {
+        std::scoped_lock lock{m_mutex};
+        m_worker = nullptr;
+        m_workerRuntime = nullptr;
+        m_parentRuntime = nullptr;
+    }
+
+    void WorkerChannel::DispatchToParent(MoveOnlyFunction<void(Worker&, Napi::Env)> work)
+    {
+        std::scoped_lock lock{m_mutex};
+        if (m_parentRuntime != nullptr)
+        {
+            m_parentRuntime->Dispatch([channel{shared_from_this()}, work{std::move(work)}](Napi::Env env) {
+                // The Worker may have been terminated since the work was dispatched.
+                if (channel->m_worker != nullptr)
+                {
+                    work(*channel->m_worker, env);
+                }
+            });
+        }
+    }
+
+    void WorkerChannel::DispatchToWorker(MoveOnlyFunction<void(Napi::Env)> work)
+    {
+        std::scoped_lock lock{m_mutex};
+        if (m_workerRuntime != nullptr)
+        {
+            m_workerRuntime->Dispatch(std::move(work));
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Babylon/AppRuntime.h>
+#include <Babylon/JsRuntime.h>
+#include <Babylon/MoveOnlyFunction.h>
+
+#include <memory>
+#include <mutex>
+
+namespace Babylon::Polyfills::Internal
+{
+    class Worker;
+
+    // The link between a Worker, on the thread of the environment which created it, and the runtime of the
+    // worker. Work dispatched either way after the link is closed is dropped without being run, so that
+    // neither side has to care about the lifetime of the other.
+    class WorkerChannel final : public std::enable_shared_from_this<WorkerChannel>
+    {
+    public:
+        WorkerChannel(JsRuntime& parentRuntime);
+
+        // Only called from the thread of the parent environment.
+        void Open(Worker& worker, AppRuntime& workerRuntime);
+        void Close();
+
+        // The work only runs if the Worker is still around by the time it gets to run.
+        void DispatchToParent(MoveOnlyFunction<void(Worker&, Napi::Env)> work);
+        void DispatchToWorker(MoveOnlyFunction<void(Napi::Env)> work);
+
+    private:
+        std::mutex m_mutex{};
+        JsRuntime* m_parentRuntime{};
+        AppRuntime* m_workerRuntime{};
+
+        // Only accessed from the thread of the parent environment.
+        Worker* m_worker{};
+    };
+}
@@ -0,0 +1,102 @@
+#include "WorkerScope.h"
+#include "Worker.h"
+
+#include <Babylon/JsRuntime.h>
+
+namespace Babylon::Polyfills::Internal
+{
+    namespace
+    {
+        constexpr auto JS_CLASS_NAME = "WorkerGlobalScope";
+        constexpr auto JS_WORKER_SCOPE_NAME = "workerScope";
+        constexpr auto JS_SELF_NAME = "self";
+        constexpr auto JS_POST_MESSAGE_NAME = "postMessage";
+        constexpr auto JS_CLOSE_NAME = "close";
+        constexpr auto JS_ADD_EVENT_LISTENER_NAME = "addEventListener";
+        constexpr auto JS_REMOVE_EVENT_LISTENER_NAME = "removeEventListener";
+
+        namespace EventType
+        {
+            constexpr const char* Message = "message";
+        }
+    }
+
+    void WorkerScope::Initialize(Napi::Env env, std::shared_ptr<WorkerChannel> channel)
+    {
+        Napi::HandleScope scope{env};
+
+        Napi::Function constructor = DefineClass(
+            env,
+            JS_CLASS_NAME,
+            {});
+
+        auto global = env.Global();
+        auto jsWorkerScope = constructor.New({});
+        auto* workerScope = WorkerScope::Unwrap(jsWorkerScope);
+        workerScope->m_channel = std::move(channel);
+
+        JsRuntime::NativeObject::GetFromJavaScript(env).Set(JS_WORKER_SCOPE_NAME, jsWorkerScope);
+
+        global.Set(JS_SELF_NAME, global);
+        global.Set(JS_POST_MESSAGE_NAME, Napi::Function::New(env, &WorkerScope::PostMessage, JS_POST_MESSAGE_NAME, workerScope));
+        global.Set(JS_CLOSE_NAME, Napi::Function::New(env, &WorkerScope::Close, JS_CLOSE_NAME, workerScope));
+        global.Set(JS_ADD_EVENT_LISTENER_NAME, Napi::Function::New(env, &WorkerScope::AddEventListener, JS_ADD_EVENT_LISTENER_NAME, workerScope));
+        global.Set(JS_REMOVE_EVENT_LISTENER_NAME, Napi::Function::New(env, &WorkerScope::RemoveEventListener, JS_REMOVE_EVENT_LISTENER_NAME, workerScope));
+    }
+
+    WorkerScope& WorkerScope::GetFromJavaScript(Napi::Env env)
+    {
+        return *WorkerScope::Unwrap(JsRuntime::NativeObject::GetFromJavaScript(env).Get(JS_WORKER_SCOPE_NAME).As<Napi::Object>());
+    }
+
+    WorkerScope::WorkerScope(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<WorkerScope>{info}
+    {
+    }
+
+    void WorkerScope::RaiseMessage(const Message& message)
+    {
+        // Messages which were already on their way when the worker closed itself are dropped.
+        if (m_closed)
+        {
+            return;
+        }
+
+        Napi::HandleScope scope{Env()};
+
+        auto event = Napi::Object::New(Env());
+        event.Set("data", message.Deserialize(Env()));
+        m_eventListeners.Raise(Env().Global(), EventType::Message, event);
+    }
+
+    void WorkerScope::PostMessage(const Napi::CallbackInfo& info)
+    {
+        auto& workerScope = *static_cast<WorkerScope*>(info.Data());
+        workerScope.m_channel->DispatchToParent([message{Message::Serialize(info[0], info[1])}](Worker& worker, Napi::Env) {
+            worker.RaiseMessage(message);
+        });
+    }
+
+    void WorkerScope::Close(const Napi::CallbackInfo& info)
+    {
+        // The worker can't stop its own thread, so it asks the Worker to terminate it, as soon as the work
+        // currently running completes.
+        auto& workerScope = *static_cast<WorkerScope*>(info.Data());
+        workerScope.m_closed = true;
+        workerScope.m_channel->DispatchToParent([](Worker& worker, Napi::Env) {
+            worker.Close();
+        });
+    }
+
+    void WorkerScope::AddEventListener(const Napi::CallbackInfo& info)
+    {
+        auto& workerScope = *static_cast<WorkerScope*>(info.Data());
+        workerScope.m_eventListeners.Add(info);
+    }
+
+    void WorkerScope::RemoveEventListener(const Napi::CallbackInfo& info)
+    {
+        auto& workerScope = *static_cast<WorkerScope*>(info.Data());
+        workerScope.m_eventListeners.Remove(info);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "EventListeners.h"
+#include "Message.h"
+#include "WorkerChannel.h"
+
+#include <napi/napi.h>
+
+#include <memory>
+
+namespace Babylon::Polyfills::Internal
+{
+    // The global scope of a worker, as seen from its script: postMessage, close and the message event
+    // listeners, all on the global object itself.
+    class WorkerScope final : public Napi::ObjectWrap<WorkerScope>
+    {
+    public:
+        static void Initialize(Napi::Env env, std::shared_ptr<WorkerChannel> channel);
+        static WorkerScope& GetFromJavaScript(Napi::Env env);
+
+        explicit WorkerScope(const Napi::CallbackInfo& info);
+
+        void RaiseMessage(const Message& message);
+
+    private:
+        static void PostMessage(const Napi::CallbackInfo& info);
+        static void Close(const Napi::CallbackInfo& info);
+        static void AddEventListener(const Napi::CallbackInfo& info);
+        static void RemoveEventListener(const Napi::CallbackInfo& info);
+
+        std::shared_ptr<WorkerChannel> m_channel{};
+        EventListeners m_eventListeners{};
+        bool m_closed{false};
+    };
+}